@@ -0,0 +1,194 @@
+#pragma once
+#include "../vendor/fluxdb/query_parser.hpp"
+#include "../src/alloc_hooks.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Minimal benchmark harness: calibrated timing loop, allocation counting
+// and JSON results that can be diffed against a stored baseline.
+//
+// Replaces the global operator new/delete (alloc_hooks.hpp), so include it
+// from exactly one translation unit per executable.
+
+namespace Bench {
+
+    struct AllocStats {
+        std::atomic<uint64_t> count{0};
+        std::atomic<uint64_t> bytes{0};
+    };
+
+    inline AllocStats& Allocs() {
+        static AllocStats stats;
+        return stats;
+    }
+
+    template <typename T>
+    inline void DoNotOptimize(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+        asm volatile("" : : "r,m"(value) : "memory");
+#else
+        static volatile const void* sink;
+        sink = &value;
+#endif
+    }
+
+    struct Result {
+        std::string name;
+        uint64_t iterations = 0;
+        double ns_per_op = 0;
+        double bytes_per_op = 0;
+        double allocs_per_op = 0;
+    };
+
+    class Runner {
+    private:
+        std::string filter;
+        double min_seconds;
+        std::vector<Result> results;
+
+    public:
+        Runner(std::string name_filter, double min_time) : filter(std::move(name_filter)), min_seconds(min_time) {}
+
+        bool selected(const std::string& name) const {
+            return filter.empty() || name.find(filter) != std::string::npos;
+        }
+
+        // fn runs one op. Iterations double until the batch takes min_time.
+        void run(const std::string& name, const std::function<void()>& fn) {
+            if (!selected(name)) return;
+            using clock = std::chrono::steady_clock;
+
+            fn(); // warm caches and lazy statics
+
+            uint64_t iters = 1;
+            while (true) {
+                uint64_t a0 = Allocs().count, b0 = Allocs().bytes;
+                auto t0 = clock::now();
+                for (uint64_t i = 0; i < iters; i++) fn();
+                double elapsed = std::chrono::duration<double>(clock::now() - t0).count();
+                uint64_t a1 = Allocs().count, b1 = Allocs().bytes;
+
+                if (elapsed >= min_seconds || iters >= (1ull << 30)) {
+                    Result r;
+                    r.name = name;
+                    r.iterations = iters;
+                    r.ns_per_op = elapsed * 1e9 / iters;
+                    r.bytes_per_op = (double)(b1 - b0) / iters;
+                    r.allocs_per_op = (double)(a1 - a0) / iters;
+                    results.push_back(r);
+                    std::printf("%-40s %12.1f ns/op %12.1f B/op %10.1f allocs/op  (%llu iters)\n",
+                                name.c_str(), r.ns_per_op, r.bytes_per_op, r.allocs_per_op, (unsigned long long)iters);
+                    return;
+                }
+
+                // aim a little past min_time so we usually finish in one more round
+                double scale = elapsed > 0 ? (min_seconds * 1.2) / elapsed : 10.0;
+                if (scale < 2.0) scale = 2.0;
+                if (scale > 100.0) scale = 100.0;
+                iters = (uint64_t)(iters * scale);
+            }
+        }
+
+        const std::vector<Result>& all() const { return results; }
+
+        // Fixed notation only: the driver's parser has no exponent support
+        std::string toJson() const {
+            std::ostringstream out;
+            out << "{\"benchmarks\": [\n";
+            for (size_t i = 0; i < results.size(); i++) {
+                const Result& r = results[i];
+                char line[512];
+                std::snprintf(line, sizeof(line),
+                    "  {\"name\": \"%s\", \"iterations\": %llu, \"ns_per_op\": %.3f, \"bytes_per_op\": %.3f, \"allocs_per_op\": %.3f}",
+                    r.name.c_str(), (unsigned long long)r.iterations, r.ns_per_op, r.bytes_per_op, r.allocs_per_op);
+                out << line << (i + 1 < results.size() ? ",\n" : "\n");
+            }
+            out << "]}\n";
+            return out.str();
+        }
+
+        // Prints the change against a previous toJson() file. Returns the number
+        // of benchmarks whose ns/op or allocs/op grew by more than threshold_pct.
+        int compare(const std::string& baseline_path, double threshold_pct) const {
+            std::ifstream in(baseline_path);
+            if (!in.is_open()) {
+                std::cerr << "[bench] Could not open baseline " << baseline_path << "\n";
+                return -1;
+            }
+            std::stringstream buf;
+            buf << in.rdbuf();
+
+            fluxdb::Document base;
+            try {
+                base = fluxdb::QueryParser(buf.str()).parseJSON();
+            } catch (const std::exception& e) {
+                std::cerr << "[bench] Bad baseline: " << e.what() << "\n";
+                return -1;
+            }
+
+            // Valid JSON of the wrong shape is as bad as a parse error
+            struct Entry { std::string name; double ns = 0, allocs = 0; };
+            std::vector<Entry> entries;
+            auto number = [](const fluxdb::Document& d, const char* key, double& out) {
+                auto it = d.find(key);
+                if (it == d.end() || !it->second || !it->second->isNumber()) return false;
+                out = it->second->getNumeric();
+                return true;
+            };
+            auto list = base.find("benchmarks");
+            bool shaped = list != base.end() && list->second && list->second->type == fluxdb::Type::Array;
+            if (shaped) {
+                for (const auto& entry : list->second->asArray()) {
+                    Entry e;
+                    shaped = entry && entry->type == fluxdb::Type::Object;
+                    if (!shaped) break;
+                    const fluxdb::Document& b = entry->asObject();
+                    auto name = b.find("name");
+                    shaped = name != b.end() && name->second && name->second->type == fluxdb::Type::String &&
+                             number(b, "ns_per_op", e.ns) && number(b, "allocs_per_op", e.allocs);
+                    if (!shaped) break;
+                    e.name = name->second->asString();
+                    entries.push_back(std::move(e));
+                }
+            }
+            if (!shaped) {
+                std::cerr << "[bench] Bad baseline: expected {\"benchmarks\": [{\"name\", \"ns_per_op\", \"allocs_per_op\"}, ...]}\n";
+                return -1;
+            }
+
+            int regressions = 0;
+            std::printf("\n%-40s %12s %12s %9s %12s\n", "vs baseline", "base ns", "now ns", "delta", "allocs");
+            for (const Entry& b : entries) {
+                const std::string& name = b.name;
+                for (const Result& r : results) {
+                    if (r.name != name) continue;
+                    double base_ns = b.ns;
+                    double base_allocs = b.allocs;
+                    double delta = base_ns > 0 ? (r.ns_per_op - base_ns) * 100.0 / base_ns : 0.0;
+                    bool worse = delta > threshold_pct || r.allocs_per_op > base_allocs + 0.5;
+                    if (worse) regressions++;
+                    std::printf("%-40s %12.1f %12.1f %+8.1f%% %5.1f->%-5.1f %s\n", name.c_str(), base_ns, r.ns_per_op,
+                                delta, base_allocs, r.allocs_per_op, worse ? "REGRESSED" : "");
+                }
+            }
+            return regressions;
+        }
+    };
+}
+
+// --- GLOBAL ALLOCATION HOOKS ---
+
+void FluxCountAllocation(std::size_t size) noexcept {
+    Bench::Allocs().count.fetch_add(1, std::memory_order_relaxed);
+    Bench::Allocs().bytes.fetch_add(size, std::memory_order_relaxed);
+}
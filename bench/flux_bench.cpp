@@ -0,0 +1,417 @@
+#include "bench_harness.hpp"
+#include "../vendor/fluxdb/fluxdb_client.hpp"
+#include "../tools/fluxd_mock/mock_server.hpp"
+
+#include <algorithm>
+#include <random>
+
+// flux_bench: microbenchmarks for the driver hot paths (parser, serializer,
+// comparators, document construction, binary codec, prepared queries) over
+// CRM-shaped payloads, plus text vs binary round trips against an in-process
+// fluxd_mock.
+//
+//   flux_bench [--filter <substr>] [--min-time <s>] [--json <out>] [--baseline <file>] [--threshold <pct>]
+
+using namespace fluxdb;
+
+namespace {
+
+    const char* FIRST[] = { "Ada", "Grace", "Linus", "Ken", "Barbara", "Dennis", "Margaret", "Edsger" };
+    const char* COMPANY[] = { "Acme Corp", "Globex", "Initech", "Umbrella", "Stark Industries", "Wayne Enterprises" };
+    const char* STAGE[] = { "New", "Contacted", "Won" };
+
+    // Same fields and construction as CRMSystem::addLead
+    Document makeLead(std::mt19937& rng) {
+        Document doc;
+        doc["type"] = std::make_shared<Value>("lead");
+        doc["name"] = std::make_shared<Value>(std::string(FIRST[rng() % 8]) + " " + std::to_string(rng() % 10000));
+        doc["company"] = std::make_shared<Value>(COMPANY[rng() % 6]);
+        doc["status"] = std::make_shared<Value>(STAGE[rng() % 3]);
+        doc["value"] = std::make_shared<Value>((int64_t)(rng() % 100000));
+        return doc;
+    }
+
+    // Same fields as CRMSystem::addTask
+    Document makeTask(std::mt19937& rng) {
+        Document doc;
+        doc["type"] = std::make_shared<Value>("task");
+        doc["parent_id"] = std::make_shared<Value>((int64_t)(rng() % 100000));
+        doc["description"] = std::make_shared<Value>("Follow up on proposal " + std::to_string(rng() % 1000));
+        doc["due_date"] = std::make_shared<Value>("2026-0" + std::to_string(1 + rng() % 9) + "-1" + std::to_string(rng() % 10));
+        doc["done"] = std::make_shared<Value>((rng() % 2) == 0);
+        return doc;
+    }
+
+    // What fluxd_mock sends back for a FIND of `rows` leads
+    std::string makeFindResponse(size_t rows) {
+        std::mt19937 rng(42);
+        std::string resp = "OK COUNT=" + std::to_string(rows);
+        for (size_t i = 0; i < rows; i++) {
+            resp += "\nID " + std::to_string(i + 1) + " " + Value(makeLead(rng)).ToJson();
+        }
+        return resp;
+    }
+
+    // The same rows as a binary FIND reply body, as the mock encodes them
+    std::string makeBinaryFindResponse(size_t rows) {
+        std::mt19937 rng(42);
+        wire::KeyEncoder keys;
+        std::string body;
+        wire::Writer w(body);
+        w.varint(rows);
+        for (size_t i = 0; i < rows; i++) {
+            w.varint(i + 1);
+            w.doc(makeLead(rng), keys);
+        }
+        return body;
+    }
+
+    std::vector<Document> decodeBinaryFind(const std::string& body) {
+        wire::KeyDecoder keys;
+        wire::Reader in(body.data(), body.size());
+        std::vector<Document> docs;
+        uint64_t rows = in.varint();
+        docs.reserve(rows);
+        for (uint64_t i = 0; i < rows; i++) {
+            Id id = in.varint();
+            Document d = in.doc(keys);
+            d["_id"] = std::make_shared<Value>((int64_t)id);
+            docs.push_back(std::move(d));
+        }
+        return docs;
+    }
+
+    // Text vs binary over loopback. Server work and both ends' allocations
+    // are included; bytes on the wire per op are printed after each case.
+    void registerRoundTrips(Bench::Runner& r) {
+        bool any = false;
+        for (const char* name : { "roundtrip/update_text", "roundtrip/update_binary", "roundtrip/find_100_text", "roundtrip/find_100_binary" })
+            any = any || r.selected(name);
+        if (!any) return;
+
+        Mock::ServerConfig config;
+        config.port = 0;
+        config.password = "";
+        Mock::MockServer server(config);
+        if (!server.start()) {
+            std::cerr << "[bench] Could not start the mock server, skipping roundtrip/\n";
+            return;
+        }
+
+        std::mt19937 rng(3);
+        const Document lead = makeLead(rng);
+        Document query;
+        query["type"] = std::make_shared<Value>("lead");
+
+        for (auto protocol : { FluxDBClient::Protocol::Text, FluxDBClient::Protocol::Negotiate }) {
+            FluxDBClient client("127.0.0.1", server.port(), protocol);
+            std::string suffix = client.isBinary() ? "_binary" : "_text";
+            client.use(client.isBinary() ? "bench_binary" : "bench_text");
+            for (int i = 0; i < 100; i++) client.insert(lead);
+
+            auto measure = [&](const std::string& name, const std::function<void()>& op) {
+                uint64_t calls = 0;
+                uint64_t before = server.stats().bytes_in + server.stats().bytes_out;
+                r.run(name + suffix, [&]() { op(); calls++; });
+                uint64_t after = server.stats().bytes_in + server.stats().bytes_out;
+                if (calls) std::printf("%-40s %12.1f wire B/op\n", "", (double)(after - before) / calls);
+            };
+
+            measure("roundtrip/update", [&]() {
+                bool ok = client.update(1, lead);
+                Bench::DoNotOptimize(ok);
+            });
+
+            measure("roundtrip/find_100", [&]() {
+                auto docs = client.find(query, 0, 100);
+                Bench::DoNotOptimize(docs);
+            });
+        }
+    }
+
+    // FIND of one lead's tasks (CRMSystem::getTasks) as the database grows,
+    // with and without the { type, parent_id } index. Each size is loaded
+    // once; the index is created after the scan cases.
+    void registerIndexedFinds(Bench::Runner& r) {
+        const size_t SIZES[] = { 1000, 10000, 100000 };
+        bool any = false;
+        for (size_t n : SIZES)
+            for (const char* kind : { "_scan", "_indexed" })
+                any = any || r.selected("index/find_tasks_" + std::to_string(n) + kind);
+        if (!any) return;
+
+        Mock::ServerConfig config;
+        config.port = 0;
+        config.password = "";
+        Mock::MockServer server(config);
+        if (!server.start()) {
+            std::cerr << "[bench] Could not start the mock server, skipping index/\n";
+            return;
+        }
+
+        for (size_t n : SIZES) {
+            FluxDBClient client("127.0.0.1", server.port());
+            client.use("bench_index_" + std::to_string(n));
+
+            // Half leads, half tasks spread over n / 10 leads
+            std::mt19937 rng(5);
+            std::vector<BatchOp> ops(n);
+            for (size_t i = 0; i < n; i++) {
+                ops[i].doc = (i % 2) ? makeTask(rng) : makeLead(rng);
+                if (i % 2) ops[i].doc["parent_id"] = std::make_shared<Value>((int64_t)(rng() % (n / 10)));
+            }
+            client.pipeline(ops);
+
+            const PreparedQuery tasks = PreparedQuery().where("type", "task").param("parent_id", Type::Int);
+            int64_t parent = 0;
+            auto find = [&]() {
+                auto docs = client.find(tasks.bind({ parent }));
+                parent = (parent + 7) % (int64_t)(n / 10);
+                Bench::DoNotOptimize(docs);
+            };
+
+            r.run("index/find_tasks_" + std::to_string(n) + "_scan", find);
+            client.createIndex({ "type", "parent_id" });
+            r.run("index/find_tasks_" + std::to_string(n) + "_indexed", find);
+        }
+    }
+
+    std::vector<Value> makeMixedValues(size_t n) {
+        std::mt19937 rng(7);
+        std::vector<Value> out;
+        out.reserve(n);
+        for (size_t i = 0; i < n; i++) {
+            switch (rng() % 4) {
+                case 0: out.emplace_back((int64_t)(rng() % 100000)); break;
+                case 1: out.emplace_back((double)(rng() % 100000) / 7.0); break;
+                case 2: out.emplace_back((rng() % 2) == 0); break;
+                default: out.emplace_back(std::string(COMPANY[rng() % 6]) + std::to_string(rng() % 100)); break;
+            }
+        }
+        return out;
+    }
+
+    void registerAll(Bench::Runner& r) {
+        std::mt19937 rng(1);
+        const Document lead = makeLead(rng);
+        const Document task = makeTask(rng);
+        const std::string leadJson = Value(lead).ToJson();
+        const std::string taskJson = Value(task).ToJson();
+
+        // --- DOCUMENT CONSTRUCTION ---
+        r.run("document/build_lead", [&]() {
+            Document d;
+            d["type"] = std::make_shared<Value>("lead");
+            d["name"] = std::make_shared<Value>(std::string("Ada Lovelace"));
+            d["company"] = std::make_shared<Value>(std::string("Acme Corp"));
+            d["status"] = std::make_shared<Value>("New");
+            d["value"] = std::make_shared<Value>((int64_t)5000);
+            Bench::DoNotOptimize(d);
+        });
+
+        r.run("document/build_query", [&]() {
+            Document q;
+            q["type"] = std::make_shared<Value>("lead");
+            q["status"] = std::make_shared<Value>(std::string("Won"));
+            Bench::DoNotOptimize(q);
+        });
+
+        // --- PREPARED QUERIES ---
+        // The getLeadsByStage query: built per call vs bound into a reused buffer
+        const PreparedQuery stage_query = PreparedQuery().where("type", "lead").param("status", Type::String);
+        const std::string stage = "Won";
+        std::string request;
+
+        r.run("query/document_tojson", [&]() {
+            Document q;
+            q["type"] = std::make_shared<Value>("lead");
+            q["status"] = std::make_shared<Value>(stage);
+            std::string s = Value(q).ToJson();
+            Bench::DoNotOptimize(s);
+        });
+
+        r.run("query/prepared_json", [&]() {
+            request.clear();
+            stage_query.bind({ stage }).writeJson(request);
+            Bench::DoNotOptimize(request);
+        });
+
+        wire::KeyEncoder query_keys;
+        r.run("query/prepared_binary", [&]() {
+            request.clear();
+            wire::Writer w(request);
+            stage_query.bind({ stage }).writeBinary(w, query_keys);
+            Bench::DoNotOptimize(request);
+        });
+
+        // --- SERIALIZER ---
+        r.run("tojson/lead", [&]() {
+            std::string s = Value(lead).ToJson();
+            Bench::DoNotOptimize(s);
+        });
+
+        r.run("tojson/task", [&]() {
+            std::string s = Value(task).ToJson();
+            Bench::DoNotOptimize(s);
+        });
+
+        r.run("tojson/double", [&]() {
+            std::string s = Value(12345.678).ToJson();
+            Bench::DoNotOptimize(s);
+        });
+
+        // --- PARSER ---
+        r.run("parse/lead", [&]() {
+            Document d = QueryParser(leadJson).parseJSON();
+            Bench::DoNotOptimize(d);
+        });
+
+        r.run("parse/task", [&]() {
+            Document d = QueryParser(taskJson).parseJSON();
+            Bench::DoNotOptimize(d);
+        });
+
+        for (size_t rows : { (size_t)100, (size_t)10000, (size_t)100000 }) {
+            std::string resp = makeFindResponse(rows);
+            r.run("parse/find_response_" + std::to_string(rows), [resp]() {
+                auto docs = FluxDBClient::parseFindResponse(resp);
+                Bench::DoNotOptimize(docs);
+            });
+        }
+
+        // Above parallelDecodeBytes() the reply is decoded in chunks across cores;
+        // this pins the same reply to one thread for the speedup
+        const std::string big_resp = makeFindResponse(100000);
+        r.run("parse/find_response_100000_serial", [&]() {
+            auto docs = FluxDBClient::parseFindResponse(big_resp, SIZE_MAX);
+            Bench::DoNotOptimize(docs);
+        });
+
+        // --- BINARY CODEC ---
+        r.run("wire/encode_lead", [&]() {
+            wire::KeyEncoder keys; // first use of every name, like a fresh connection
+            std::string out;
+            wire::Writer w(out);
+            w.doc(lead, keys);
+            Bench::DoNotOptimize(out);
+        });
+
+        wire::KeyEncoder warm_keys;
+        {
+            std::string sink;
+            wire::Writer(sink).doc(lead, warm_keys);
+        }
+        std::string encoded;
+        r.run("wire/encode_lead_interned", [&]() {
+            encoded.clear();
+            wire::Writer w(encoded);
+            w.doc(lead, warm_keys);
+            Bench::DoNotOptimize(encoded);
+        });
+
+        for (size_t rows : { (size_t)100, (size_t)10000, (size_t)100000 }) {
+            std::string body = makeBinaryFindResponse(rows);
+            r.run("wire/find_response_" + std::to_string(rows), [body]() {
+                auto docs = decodeBinaryFind(body);
+                Bench::DoNotOptimize(docs);
+            });
+        }
+
+        // --- SPANS ---
+        // FLUX_SPAN on hot paths must cost next to nothing while not recording
+        r.run("span/disabled", [&]() {
+            FLUX_SPAN("bench");
+        });
+
+        SpanRecorder::start();
+        r.run("span/enabled", [&]() {
+            FLUX_SPAN("bench");
+        });
+        SpanRecorder::stop();
+        SpanRecorder::clear();
+
+        registerRoundTrips(r);
+        registerIndexedFinds(r);
+
+        // --- COMPARATORS ---
+        const Value num_a((int64_t)41), num_b(41.5);
+        const Value str_a(std::string("Acme Corp 17")), str_b(std::string("Acme Corp 18"));
+        ValueLess less;
+        ValueHasher hasher;
+
+        r.run("valueless/int_vs_double", [&]() {
+            bool b = less(num_a, num_b);
+            Bench::DoNotOptimize(b);
+        });
+
+        r.run("valueless/string", [&]() {
+            bool b = less(str_a, str_b);
+            Bench::DoNotOptimize(b);
+        });
+
+        r.run("valuehasher/int", [&]() {
+            size_t h = hasher(num_a);
+            Bench::DoNotOptimize(h);
+        });
+
+        r.run("valuehasher/string", [&]() {
+            size_t h = hasher(str_a);
+            Bench::DoNotOptimize(h);
+        });
+
+        const std::vector<Value> mixed = makeMixedValues(10000);
+        r.run("valueless/sort_mixed_10000", [&]() {
+            std::vector<const Value*> order;
+            order.reserve(mixed.size());
+            for (const auto& v : mixed) order.push_back(&v);
+            std::sort(order.begin(), order.end(), [&](const Value* a, const Value* b) { return less(*a, *b); });
+            Bench::DoNotOptimize(order);
+        });
+    }
+}
+
+static void usage() {
+    std::cout <<
+        "Usage: flux_bench [options]\n"
+        "  --filter <substr>      only run cases whose name contains this\n"
+        "  --min-time <s>         minimum measured time per case (default 0.2)\n"
+        "  --json <out>           write results as JSON\n"
+        "  --baseline <file>      compare against saved JSON results; exit 1 on regressions\n"
+        "  --threshold <pct>      slowdown that counts as a regression (default 10)\n";
+}
+
+int main(int argc, char** argv) {
+    std::string filter, json_out, baseline;
+    double min_time = 0.2;
+    double threshold = 10.0;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool known = arg == "--filter" || arg == "--min-time" || arg == "--json" || arg == "--baseline" || arg == "--threshold";
+
+        if (arg == "--help" || arg == "-h") { usage(); return 0; }
+        if (!known) { std::cerr << "Unknown option " << arg << "\n"; usage(); return 2; }
+        if (i + 1 >= argc) { std::cerr << "Missing value for " << arg << "\n"; usage(); return 2; }
+
+        if (arg == "--filter") filter = argv[++i];
+        else if (arg == "--min-time") min_time = std::atof(argv[++i]);
+        else if (arg == "--json") json_out = argv[++i];
+        else if (arg == "--baseline") baseline = argv[++i];
+        else if (arg == "--threshold") threshold = std::atof(argv[++i]);
+    }
+
+    Bench::Runner runner(filter, min_time);
+    registerAll(runner);
+
+    if (!json_out.empty()) {
+        std::ofstream out(json_out);
+        out << runner.toJson();
+        std::cout << "\n[bench] Wrote " << json_out << "\n";
+    }
+
+    if (!baseline.empty()) {
+        int regressions = runner.compare(baseline, threshold);
+        if (regressions != 0) return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,273 @@
+#include "../src/ui/context.hpp"
+#include "../src/ui/sidebar.hpp"
+#include "../src/ui/pipeline.hpp"
+#include "../src/ui/analytics.hpp"
+#include "../src/ui/statusbar.hpp"
+#include "../tools/fluxd_mock/mock_server.hpp"
+// Allocations per frame are part of the report, so counting is always on here
+#ifndef FLUX_ALLOC_STATS
+#define FLUX_ALLOC_STATS
+#endif
+#include "../src/alloc_counter.hpp"
+
+#include "imgui_impl_null.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// flux_gui_bench: the real GUI panels, headless. Each dataset gets an
+// in-process fluxd_mock seeded with n leads (and a task for every tenth),
+// then the same frame loop as flux_crm runs on imgui's null backend with a
+// simulated 60 Hz clock, so the 2 s data refresh and ticker invalidations
+// land where they would on a desktop. Reports frame-time percentiles,
+// server commands per frame and render-thread allocations per frame.
+//
+//   flux_gui_bench [--leads 1000,10000,100000] [--frames 600] [--warmup 5]
+//                  [--latency-ms 0] [--event-every 0] [--json <out>] [--spans <out>]
+
+namespace {
+
+    struct Options {
+        std::vector<size_t> leads{ 1000, 10000, 100000 };
+        size_t frames = 600;        // measured frames per dataset (10 s simulated)
+        size_t warmup = 5;          // first frames: connect, font atlas, initial load
+        int latency_ms = 0;         // mock network delay
+        size_t event_every = 0;     // publish a crm_event every n frames (0 = never)
+        std::string json_out;
+        std::string spans_out;      // Chrome trace of the measured frames
+    };
+
+    struct FrameStats {
+        size_t leads = 0;
+        double seed_s = 0;
+        double first_ms = 0;        // the first frame, which loads everything
+        double p50_ms = 0, p90_ms = 0, p99_ms = 0, max_ms = 0;
+        double requests_mean = 0;
+        uint64_t requests_max = 0;
+        double allocs_mean = 0;
+        uint64_t allocs_max = 0;
+    };
+
+    const char* FIRST[] = { "Ada", "Grace", "Linus", "Ken", "Barbara", "Dennis", "Margaret", "Edsger" };
+    const char* COMPANY[] = { "Acme Corp", "Globex", "Initech", "Umbrella", "Stark Industries", "Wayne Enterprises" };
+    const char* STAGE[] = { "New", "Contacted", "Won" };
+
+    // "YYYY-MM-DD", days from today
+    std::string dueDate(int days) {
+        std::time_t t = std::time(nullptr) + (std::time_t)days * 86400;
+        char buf[16];
+        std::strftime(buf, sizeof(buf), "%Y-%m-%d", std::localtime(&t));
+        return buf;
+    }
+
+    // Same documents the CRM writes, pipelined in chunks. Task due dates
+    // spread over +-60 days, so about half are overdue.
+    void seed(int port, size_t leads) {
+        fluxdb::FluxDBClient client("127.0.0.1", port);
+        client.auth("flux_admin");
+        client.use("crm_db");
+
+        const size_t CHUNK = 10000;
+        std::mt19937 rng((unsigned)leads);
+        std::vector<fluxdb::BatchOp> ops;
+        std::vector<fluxdb::Id> ids;
+        for (size_t done = 0; done < leads; done += CHUNK) {
+            ops.clear();
+            for (size_t i = done; i < std::min(leads, done + CHUNK); i++) {
+                Lead l;
+                l.name = std::string(FIRST[rng() % 8]) + " " + std::to_string(i);
+                l.company = COMPANY[rng() % 6];
+                l.status = STAGE[rng() % 3];
+                l.value = (int)(rng() % 100000);
+                ops.push_back(CRMSystem::batchAddLead(l));
+            }
+            for (const auto& r : client.pipeline(ops))
+                if (r.ok) ids.push_back(r.id);
+        }
+
+        ops.clear();
+        for (size_t i = 0; i < ids.size(); i += 10) {
+            ops.push_back(CRMSystem::batchAddTask(ids[i], "Follow up", dueDate((int)(rng() % 121) - 60)));
+            if (ops.size() == CHUNK) { client.pipeline(ops); ops.clear(); }
+        }
+        if (!ops.empty()) client.pipeline(ops);
+    }
+
+    double percentile(std::vector<double> v, double p) {
+        if (v.empty()) return 0;
+        std::sort(v.begin(), v.end());
+        size_t i = (size_t)(p * (double)(v.size() - 1) + 0.5);
+        return v[std::min(i, v.size() - 1)];
+    }
+
+    bool runDataset(const Options& opt, size_t leads, FrameStats& out) {
+        using clock = std::chrono::steady_clock;
+        out.leads = leads;
+
+        Mock::ServerConfig config;
+        config.port = 0;
+        config.faults.latency_ms = opt.latency_ms;
+        Mock::MockServer server(config);
+        if (!server.start()) {
+            std::cerr << "[gui] Could not start the mock server\n";
+            return false;
+        }
+
+        auto t0 = clock::now();
+        seed(server.port(), leads);
+        out.seed_s = std::chrono::duration<double>(clock::now() - t0).count();
+
+        ImGui::CreateContext();
+        ImPlot::CreateContext();
+        ImGui::GetIO().IniFilename = nullptr;
+        ImGui_ImplNull_Init();
+
+        {
+            // Connect the way the sidebar's button does
+            UI::AppState state;
+            state.server_port = server.port();
+            state.details.clear();
+            if (!state.crm.connect(state.server_ip, state.server_port, state.password)) {
+                std::cerr << "[gui] Connect failed: " << state.crm.getError() << "\n";
+            } else {
+                state.is_connected = true;
+                state.status_msg = "Online";
+                state.ticker.start(state.server_ip, state.server_port, state.password);
+            }
+
+            std::unique_ptr<fluxdb::FluxDBClient> publisher;
+            if (opt.event_every) {
+                publisher = std::make_unique<fluxdb::FluxDBClient>("127.0.0.1", server.port());
+                publisher->auth("flux_admin");
+            }
+
+            if (!opt.spans_out.empty()) fluxdb::SpanRecorder::start();
+            std::vector<double> frame_ms;
+            std::vector<uint64_t> requests, allocs;
+            size_t total = opt.warmup + opt.frames;
+            for (size_t f = 0; f < total; f++) {
+                if (publisher && f >= opt.warmup && (f - opt.warmup) % opt.event_every == opt.event_every - 1)
+                    publisher->publish("crm_events", "Lead Updated: bench");
+
+                uint64_t commands_before = server.stats().commands;
+                uint64_t allocs_before = CRM::ThreadAllocations();
+                auto start = clock::now();
+
+                FLUX_SPAN("frame");
+                ImGui_ImplNull_NewFrame();
+                ImGui::NewFrame();
+                state.BeginFrame((double)f / 60.0);
+                UI::RenderSidebar(state);
+                if (state.is_connected) {
+                    UI::RenderPipeline(state);
+                    UI::RenderAnalytics(state);
+                    UI::RenderStatusBar(state);
+                }
+                if (state.reset_layout) state.reset_layout = false;
+                ImGui::Render();
+                ImGui_ImplNullRender_RenderDrawData(ImGui::GetDrawData());
+
+                double ms = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+                if (f == 0) out.first_ms = ms;
+                if (f < opt.warmup) continue;
+                frame_ms.push_back(ms);
+                requests.push_back(server.stats().commands - commands_before);
+                allocs.push_back(CRM::ThreadAllocations() - allocs_before);
+            }
+
+            state.ticker.stop();
+            if (!opt.spans_out.empty()) {
+                // One file per dataset: "<out>" becomes "<out>.<leads>.json"
+                fluxdb::SpanRecorder::stop();
+                fluxdb::SpanRecorder::dump(opt.spans_out + "." + std::to_string(leads) + ".json");
+            }
+
+            out.p50_ms = percentile(frame_ms, 0.50);
+            out.p90_ms = percentile(frame_ms, 0.90);
+            out.p99_ms = percentile(frame_ms, 0.99);
+            out.max_ms = frame_ms.empty() ? 0 : *std::max_element(frame_ms.begin(), frame_ms.end());
+            for (size_t i = 0; i < requests.size(); i++) {
+                out.requests_mean += (double)requests[i] / (double)requests.size();
+                out.allocs_mean += (double)allocs[i] / (double)allocs.size();
+                out.requests_max = std::max(out.requests_max, requests[i]);
+                out.allocs_max = std::max(out.allocs_max, allocs[i]);
+            }
+        }
+
+        ImGui_ImplNull_Shutdown();
+        ImPlot::DestroyContext();
+        ImGui::DestroyContext();
+        server.stop();
+        return true;
+    }
+
+    std::string toJson(const std::vector<FrameStats>& all) {
+        std::ostringstream os;
+        os << "[\n";
+        for (size_t i = 0; i < all.size(); i++) {
+            const FrameStats& s = all[i];
+            os << "  {\"leads\":" << s.leads << ",\"first_ms\":" << s.first_ms << ",\"p50_ms\":" << s.p50_ms
+               << ",\"p90_ms\":" << s.p90_ms << ",\"p99_ms\":" << s.p99_ms << ",\"max_ms\":" << s.max_ms
+               << ",\"requests_per_frame\":" << s.requests_mean << ",\"requests_max\":" << s.requests_max
+               << ",\"allocs_per_frame\":" << s.allocs_mean << ",\"allocs_max\":" << s.allocs_max << "}"
+               << (i + 1 < all.size() ? ",\n" : "\n");
+        }
+        os << "]\n";
+        return os.str();
+    }
+}
+
+int main(int argc, char** argv) {
+    Options opt;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool known = arg == "--leads" || arg == "--frames" || arg == "--warmup" || arg == "--latency-ms" ||
+                     arg == "--event-every" || arg == "--json" || arg == "--spans";
+        if (!known) { std::cerr << "Unknown option " << arg << "\n"; return 2; }
+        if (i + 1 >= argc) { std::cerr << "Missing value for " << arg << "\n"; return 2; }
+        if (arg == "--leads") {
+            opt.leads.clear();
+            std::stringstream list(argv[++i]);
+            std::string item;
+            while (std::getline(list, item, ',')) opt.leads.push_back(std::strtoull(item.c_str(), nullptr, 10));
+        }
+        else if (arg == "--frames") opt.frames = std::strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--warmup") opt.warmup = std::strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--latency-ms") opt.latency_ms = std::atoi(argv[++i]);
+        else if (arg == "--event-every") opt.event_every = std::strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--json") opt.json_out = argv[++i];
+        else if (arg == "--spans") opt.spans_out = argv[++i];
+    }
+    if (opt.frames == 0) { std::cerr << "--frames must be at least 1\n"; return 2; }
+
+    std::printf("%-9s %8s %9s %8s %8s %8s %8s %10s %7s %11s %9s\n",
+                "leads", "seed_s", "first_ms", "p50_ms", "p90_ms", "p99_ms", "max_ms", "req/frame", "max_req", "allocs/frm", "max_alloc");
+
+    std::vector<FrameStats> all;
+    for (size_t n : opt.leads) {
+        FrameStats s;
+        if (!runDataset(opt, n, s)) return 1;
+        std::printf("%-9zu %8.2f %9.2f %8.3f %8.3f %8.3f %8.3f %10.3f %7llu %11.1f %9llu\n",
+                    s.leads, s.seed_s, s.first_ms, s.p50_ms, s.p90_ms, s.p99_ms, s.max_ms,
+                    s.requests_mean, (unsigned long long)s.requests_max, s.allocs_mean, (unsigned long long)s.allocs_max);
+        std::fflush(stdout);
+        all.push_back(s);
+    }
+
+    if (!opt.json_out.empty()) {
+        std::ofstream out(opt.json_out);
+        out << toJson(all);
+        std::cout << "[gui] Wrote " << opt.json_out << "\n";
+    }
+    return 0;
+}
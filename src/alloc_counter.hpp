@@ -0,0 +1,34 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// Counts heap allocations per thread so the GUI can report how many the
+// render thread made in a frame (--alloc-stats). Steady-state frames should
+// show zero; anything else means a temporary escaped the frame arena.
+//
+// Counting replaces the global operator new/delete (alloc_hooks.hpp), so it
+// is only compiled in with FLUX_ALLOC_STATS defined (CMake option of the same
+// name). Without it nothing is replaced and ThreadAllocations() stays 0.
+// Include from exactly one translation unit per executable.
+
+namespace CRM {
+
+    inline constexpr bool AllocStatsAvailable() {
+#ifdef FLUX_ALLOC_STATS
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    inline uint64_t& ThreadAllocations() {
+        static thread_local uint64_t count = 0;
+        return count;
+    }
+}
+
+#ifdef FLUX_ALLOC_STATS
+#include "alloc_hooks.hpp"
+
+void FluxCountAllocation(std::size_t) noexcept { CRM::ThreadAllocations()++; }
+#endif
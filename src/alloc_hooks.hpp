@@ -0,0 +1,87 @@
+#pragma once
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+// The complete set of replaceable global operator new/delete (plain, array,
+// nothrow, sized and C++17 aligned), on top of malloc/free, with every
+// allocation reported to
+//
+//   void FluxCountAllocation(std::size_t size) noexcept;
+//
+// which the including translation unit defines. Only one translation unit
+// per executable may include this.
+//
+// The operators are kept out of line: once GCC inlines them it pairs each
+// free() with the `new` expression it came from and warns
+// (-Wmismatched-new-delete).
+
+#if defined(_MSC_VER)
+#define FLUX_ALLOC_HOOK __declspec(noinline)
+#else
+#define FLUX_ALLOC_HOOK __attribute__((noinline))
+#endif
+
+void FluxCountAllocation(std::size_t size) noexcept;
+
+namespace CRM {
+    namespace AllocHooks {
+
+        // nullptr on failure; align 0 means the default alignment
+        inline void* Allocate(std::size_t size, std::size_t align) noexcept {
+            FluxCountAllocation(size);
+            if (size == 0) size = 1;
+            if (align <= alignof(std::max_align_t)) return std::malloc(size);
+#if defined(_WIN32)
+            return _aligned_malloc(size, align);
+#else
+            void* p = nullptr;
+            return posix_memalign(&p, align, size) == 0 ? p : nullptr;
+#endif
+        }
+
+        inline void Release(void* p, std::size_t align) noexcept {
+#if defined(_WIN32)
+            if (align > alignof(std::max_align_t)) { _aligned_free(p); return; }
+#endif
+            (void)align;
+            std::free(p);
+        }
+
+        // Retries through the new_handler like the default operator new
+        inline void* AllocateOrThrow(std::size_t size, std::size_t align) {
+            while (true) {
+                if (void* p = Allocate(size, align)) return p;
+                std::new_handler handler = std::get_new_handler();
+                if (!handler) throw std::bad_alloc();
+                handler();
+            }
+        }
+
+        inline void* AllocateNoThrow(std::size_t size, std::size_t align) noexcept {
+            try { return AllocateOrThrow(size, align); } catch (...) { return nullptr; }
+        }
+    }
+}
+
+FLUX_ALLOC_HOOK void* operator new(std::size_t size) { return CRM::AllocHooks::AllocateOrThrow(size, 0); }
+FLUX_ALLOC_HOOK void* operator new[](std::size_t size) { return CRM::AllocHooks::AllocateOrThrow(size, 0); }
+FLUX_ALLOC_HOOK void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return CRM::AllocHooks::AllocateNoThrow(size, 0); }
+FLUX_ALLOC_HOOK void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return CRM::AllocHooks::AllocateNoThrow(size, 0); }
+FLUX_ALLOC_HOOK void* operator new(std::size_t size, std::align_val_t a) { return CRM::AllocHooks::AllocateOrThrow(size, (std::size_t)a); }
+FLUX_ALLOC_HOOK void* operator new[](std::size_t size, std::align_val_t a) { return CRM::AllocHooks::AllocateOrThrow(size, (std::size_t)a); }
+FLUX_ALLOC_HOOK void* operator new(std::size_t size, std::align_val_t a, const std::nothrow_t&) noexcept { return CRM::AllocHooks::AllocateNoThrow(size, (std::size_t)a); }
+FLUX_ALLOC_HOOK void* operator new[](std::size_t size, std::align_val_t a, const std::nothrow_t&) noexcept { return CRM::AllocHooks::AllocateNoThrow(size, (std::size_t)a); }
+
+FLUX_ALLOC_HOOK void operator delete(void* p) noexcept { CRM::AllocHooks::Release(p, 0); }
+FLUX_ALLOC_HOOK void operator delete[](void* p) noexcept { CRM::AllocHooks::Release(p, 0); }
+FLUX_ALLOC_HOOK void operator delete(void* p, std::size_t) noexcept { CRM::AllocHooks::Release(p, 0); }
+FLUX_ALLOC_HOOK void operator delete[](void* p, std::size_t) noexcept { CRM::AllocHooks::Release(p, 0); }
+FLUX_ALLOC_HOOK void operator delete(void* p, const std::nothrow_t&) noexcept { CRM::AllocHooks::Release(p, 0); }
+FLUX_ALLOC_HOOK void operator delete[](void* p, const std::nothrow_t&) noexcept { CRM::AllocHooks::Release(p, 0); }
+FLUX_ALLOC_HOOK void operator delete(void* p, std::align_val_t a) noexcept { CRM::AllocHooks::Release(p, (std::size_t)a); }
+FLUX_ALLOC_HOOK void operator delete[](void* p, std::align_val_t a) noexcept { CRM::AllocHooks::Release(p, (std::size_t)a); }
+FLUX_ALLOC_HOOK void operator delete(void* p, std::size_t, std::align_val_t a) noexcept { CRM::AllocHooks::Release(p, (std::size_t)a); }
+FLUX_ALLOC_HOOK void operator delete[](void* p, std::size_t, std::align_val_t a) noexcept { CRM::AllocHooks::Release(p, (std::size_t)a); }
+FLUX_ALLOC_HOOK void operator delete(void* p, std::align_val_t a, const std::nothrow_t&) noexcept { CRM::AllocHooks::Release(p, (std::size_t)a); }
+FLUX_ALLOC_HOOK void operator delete[](void* p, std::align_val_t a, const std::nothrow_t&) noexcept { CRM::AllocHooks::Release(p, (std::size_t)a); }
@@ -5,7 +5,12 @@
 #include <sstream>
 #include <vector>
 #include <iomanip>
+#include <chrono>
+#include <unordered_map>
 #include "../crm_core.hpp"
+#include "../query/lead_table.hpp"
+#include "../query/dedupe.hpp"
+#include "../io/lead_io.hpp"
 
 namespace CLI {
 
@@ -15,6 +20,14 @@ namespace CLI {
         bool running = true;
         bool is_connected = false;
 
+        static const size_t EXPORT_PAGE = 4096;
+        static const size_t IMPORT_BATCH = 4096;
+
+        // Columnar snapshot for LIST --where/--order-by/--limit
+        Query::LeadTable lead_table;
+        bool table_stale = true;
+        std::chrono::steady_clock::time_point table_loaded;
+
         std::vector<std::string> tokenize(const std::string& input) {
             std::vector<std::string> tokens;
             std::stringstream ss(input);
@@ -30,190 +43,692 @@ namespace CLI {
                       << " | " << std::setw(15) << c4 << " |\n";
         }
 
-        void exportCSV(const std::string& filename) {
-            std::ofstream file(filename);
-            if (!file.is_open()) { std::cout << "ERR Could not open file for writing.\n"; return; }
-            
-            file << "ID,Name,Company,Value,Stage\n";
+        // EXPORT <file.csv|.jsonl|.flxs>: streams every stage through paged FINDs
+        bool exportLeads(const std::string& filename) {
+            IO::Format format;
+            if (!IO::formatFromPath(filename, format)) { std::cout << "ERR Use a .csv, .jsonl or .flxs file.\n"; return false; }
+
+            IO::LeadWriter writer(filename, format);
+            if (!writer.isOpen()) { std::cout << "ERR Could not open file for writing.\n"; return false; }
+
             const char* stages[] = { "New", "Contacted", "Won" };
-            int count = 0;
-            
             for (const char* stage : stages) {
-                auto leads = crm.getLeadsByStage(stage);
-                for (const auto& l : leads) {
-                    file << l.id << "," << l.name << "," << l.company << "," << l.value << "," << stage << "\n";
-                    count++;
+                if (!crm.scanLeads(stage, EXPORT_PAGE, [&](const Lead& l) { writer.add(l); })) {
+                    writer.finish();
+                    std::cout << "ERR Export stopped after " << writer.rows() << " leads: " << crm.getError() << "\n";
+                    return false;
                 }
             }
-            std::cout << "OK Exported " << count << " leads to " << filename << "\n";
-            file.close();
+            if (!writer.finish()) { std::cout << "ERR Write to " << filename << " failed.\n"; return false; }
+            std::cout << "OK Exported " << writer.rows() << " leads to " << filename << "\n";
+            return true;
         }
 
-        void importCSV(const std::string& filename) {
-            std::ifstream file(filename);
-            if (!file.is_open()) { std::cout << "ERR Could not open file " << filename << "\n"; return; }
+        // IMPORT <file> [--dedupe]: any export format, or the legacy name,company,value CSV.
+        // Rows are inserted as pipelined batches. With dedupe, rows similar to an
+        // existing lead or an earlier row are skipped and listed.
+        bool importLeads(const std::string& filename, bool dedupe = false) {
+            IO::Format format = IO::Format::Csv;
+            IO::formatFromPath(filename, format);
 
-            std::string line;
-            int count = 0;
-            std::getline(file, line); 
-
-            while (std::getline(file, line)) {
-                if (line.empty()) continue;
-                std::stringstream ss(line);
-                std::string segment;
-                std::vector<std::string> row;
-                while(std::getline(ss, segment, ',')) row.push_back(segment);
-
-                if (row.size() >= 3) {
-                    Lead l;
-                    l.name = row[0];
-                    l.company = row[1];
-                    try { l.value = std::stoi(row[2]); } catch(...) { l.value = 0; }
-                    if (crm.addLead(l)) count++;
+            IO::LeadReader reader(filename, format);
+            if (!reader.isOpen()) { std::cout << "ERR Could not open file " << filename << "\n"; return false; }
+
+            std::vector<fluxdb::BatchOp> ops;
+            ops.reserve(IMPORT_BATCH);
+            size_t count = 0, failed = 0, skipped = 0;
+
+            // Known leads for dedupe: existing ones, then every row imported
+            Query::DuplicateIndex index;
+            std::vector<Lead> known;
+            if (dedupe) {
+                known = crm.getAllLeads();
+                for (const auto& sig : Query::DuplicateIndex::signatures(known)) index.add(sig);
+            }
+
+            std::vector<Lead> rows;
+            rows.reserve(IMPORT_BATCH);
+            auto flush = [&]() {
+                if (dedupe) {
+                    auto sigs = Query::DuplicateIndex::signatures(rows);
+                    for (size_t i = 0; i < rows.size(); i++) {
+                        int64_t dup = index.match(sigs[i]);
+                        if (dup >= 0) {
+                            const Lead& k = known[(size_t)dup];
+                            std::cout << "DUP  " << rows[i].name << " / " << rows[i].company << "  ~  "
+                                      << (k.id ? "#" + std::to_string(k.id) + " " : "") << k.name << " / " << k.company << "\n";
+                            skipped++;
+                            continue;
+                        }
+                        index.add(sigs[i]);
+                        known.push_back(rows[i]);
+                        ops.push_back(CRMSystem::batchAddLead(rows[i]));
+                    }
+                } else {
+                    for (const Lead& r : rows) ops.push_back(CRMSystem::batchAddLead(r));
                 }
+                rows.clear();
+                for (const auto& r : crm.runBatch(ops)) (r.ok ? count : failed)++;
+                ops.clear();
+            };
+
+            Lead l;
+            while (reader.next(l)) {
+                rows.push_back(std::move(l));
+                if (rows.size() == IMPORT_BATCH) flush();
             }
-            std::cout << "OK Imported " << count << " leads.\n";
-            if (count > 0) crm.publishEvent("CLI: Imported " + std::to_string(count) + " leads from CSV");
+            flush();
+
+            if (reader.corrupt()) std::cout << "ERR " << filename << " is truncated or corrupt.\n";
+            std::cout << "OK Imported " << count << " leads" << (failed ? ", " + std::to_string(failed) + " failed" : std::string())
+                      << (dedupe ? ", " + std::to_string(skipped) + " duplicates skipped" : std::string()) << ".\n";
+            if (count > 0) crm.publishEvent("CLI: Imported " + std::to_string(count) + " leads from " + filename);
+            return failed == 0 && !reader.corrupt();
         }
 
-    public:
-        void run() {
-            std::cout << "FluxCRM (CLI Mode)\nType 'HELP' for commands.\n";
+        static bool hasFlags(const std::vector<std::string>& args) {
+            for (size_t i = 1; i < args.size(); i++) if (args[i].compare(0, 2, "--") == 0) return true;
+            return false;
+        }
 
-            while (running) {
-                std::cout << (is_connected ? "flux> " : "(offline)> ");
-                std::string line;
-                if (!std::getline(std::cin, line)) break;
-                if (line.empty()) continue;
+        void refreshTable() {
+            const auto MAX_AGE = std::chrono::seconds(10);
+            auto now = std::chrono::steady_clock::now();
+            if (!table_stale && now - table_loaded < MAX_AGE) return;
 
-                std::vector<std::string> args = tokenize(line);
-                std::string cmd = args[0];
-                for (auto & c: cmd) c = toupper(c);
-
-                try {
-                    if (cmd == "EXIT") running = false;
-
-                    else if (cmd == "HELP") {
-                        std::cout <<
-                            "\nAvailable Commands:\n"
-                            "  CONNECT <ip> <port> <pass>\n"
-                            "  ADD <stage> <name> <company> <value>\n"
-                            "  LIST [stage]\n"
-                            "  PROMOTE <id> <stage>\n"
-                            "  TASK <id> <desc>\n"
-                            "  IMPORT <file.csv>\n"
-                            "  EXPORT <file.csv>\n"
-                            "  STATS\n"
-                            "  GOAL <amount>\n"
-                            "  EXIT\n\n";
-                    }
+            lead_table.load(crm.getAllLeads());
+            table_loaded = now;
+            table_stale = false;
+        }
+
+        // LIST [stage] [--where <expr>] [--order-by <field> [asc|desc]] [--limit <n>]
+        void listQuery(const std::vector<std::string>& args) {
+            Query::QuerySpec spec;
+            std::string error;
 
-                    else if (cmd == "CONNECT") {
-                        if (args.size() < 4) { std::cout << "Usage: CONNECT <ip> <port> <pass>\n"; continue; }
-                        if (crm.connect(args[1], std::stoi(args[2]), args[3])) {
-                            is_connected = true;
-                            std::cout << "OK Connected.\n";
-                        } else std::cout << "ERR " << crm.getError() << "\n";
+            for (size_t i = 1; i < args.size(); i++) {
+                if (args[i] == "--where") {
+                    std::string expr;
+                    while (i + 1 < args.size() && args[i + 1].compare(0, 2, "--") != 0) expr += args[++i] + " ";
+                    if (!Query::parseWhere(expr, spec.where, error)) { std::cout << "ERR " << error << "\n"; return; }
+                }
+                else if (args[i] == "--order-by" && i + 1 < args.size()) {
+                    spec.order.enabled = true;
+                    if (!Query::parseField(args[++i], spec.order.field)) { std::cout << "ERR Unknown field '" << args[i] << "'\n"; return; }
+                    if (i + 1 < args.size()) {
+                        std::string dir = args[i + 1];
+                        for (auto& c : dir) c = toupper(c);
+                        if (dir == "ASC" || dir == "DESC") { spec.order.descending = (dir == "DESC"); i++; }
                     }
+                }
+                else if (args[i] == "--limit" && i + 1 < args.size()) {
+                    spec.limit = std::stoul(args[++i]);
+                }
+                else if (i == 1) {
+                    spec.where.push_back({ Query::Field::Stage, "=", args[i] });
+                }
+                else { std::cout << "ERR Unexpected '" << args[i] << "'. Type HELP.\n"; return; }
+            }
 
-                    else if (!is_connected) { std::cout << "ERR Not connected.\n"; continue; }
+            refreshTable();
+            Query::Engine engine(lead_table);
+            Query::QueryResult result;
+            if (!engine.run(spec, result, error)) { std::cout << "ERR " << error << "\n"; return; }
 
-                    else if (cmd == "ADD" && args.size() >= 4) {
-                        Lead l;
-                        l.name = args[2]; l.company = args[3]; l.value = std::stoi(args[4]);
-                        if (crm.addLead(l)) {
-                            std::cout << "OK Lead Created.\n";
-                            crm.publishEvent("CLI: New Lead " + l.name); 
-                        }
-                    }
+            printRow("ID", "NAME", "COMPANY", "VALUE");
+            std::cout << "--------------------------------------------------------\n";
+            for (uint32_t r : result.rows) {
+                Lead l = lead_table.row(r);
+                printRow(std::to_string(l.id), l.name, l.company, std::to_string(l.value));
+            }
+            std::cout << "Shown: " << result.rows.size() << "  Matched: " << result.matched << " of " << lead_table.size()
+                      << "  (" << std::fixed << std::setprecision(3) << result.scan_ms << " ms)\n";
+            std::cout << std::defaultfloat;
+        }
 
-                    else if (cmd == "TASK") {
-                        if (args.size() < 3) { std::cout << "Usage: TASK <id> <desc>\n"; continue; }
-                        int id = std::stoi(args[1]);
-                        std::string desc = "";
-                        for(size_t i=2; i<args.size(); i++) desc += args[i] + " ";
-                        
-                        if (crm.addTask(id, desc, "")) {
-                            std::cout << "OK Task Added.\n";
-                            crm.publishEvent("CLI: Task added to #" + std::to_string(id));
-                        }
-                    }
+        // --- COMMANDS ---
+        // Every handler gets the tokenized line (args[0] is the command word)
+        // and returns false when the command failed.
 
-                    else if (cmd == "PROMOTE") {
-                        if (args.size() < 3) continue;
-                        int id = std::stoi(args[1]);
-                        std::string newStage = args[2];
-                        
-                        bool found = false;
-                        const char* stages[] = { "New", "Contacted", "Won" };
-                        Lead target;
-                        for (const char* s : stages) {
-                            auto leads = crm.getLeadsByStage(s);
-                            for(auto& l : leads) { if(l.id == id) { target = l; found = true; break; } }
-                            if(found) break;
-                        }
+        bool cmdExit(const std::vector<std::string>&) {
+            running = false;
+            return true;
+        }
 
-                        if(found && crm.updateLeadStatus(target, newStage)) {
-                             std::cout << "OK Promoted.\n";
-                             crm.publishEvent("CLI: Promoted " + target.name + " to " + newStage);
-                        } else std::cout << "ERR Failed.\n";
-                    }
+        bool cmdHelp(const std::vector<std::string>&) {
+            std::cout <<
+                "\nAvailable Commands:\n"
+                "  CONNECT <ip[:port],...> <port> <pass>\n"
+                "  ADD <stage> <name> <company> <value>\n"
+                "  LIST [stage] [--where <expr>] [--order-by <field> [asc|desc]] [--limit <n>]\n"
+                "  PROMOTE <id> <stage>\n"
+                "  TASK <id> <desc>\n"
+                "  IMPORT <file.csv|.jsonl|.flxs> [--dedupe]\n"
+                "  EXPORT <file.csv|.jsonl|.flxs>\n"
+                "  STATS\n"
+                "  GOAL <amount>\n"
+                "  NODES | NODE ADD <host:port> | NODE DROP <host:port>\n"
+                "  INDEXES\n"
+                "  DEDUPE [--threshold <0..1>] [--merge]\n"
+                "  FORECAST [--trials <n>] [--reload]\n"
+                "  NOTES SEARCH <words> [--limit <n>]\n"
+                "  EXIT\n\n";
+            return true;
+        }
 
-                    else if (cmd == "IMPORT") {
-                        if (args.size() < 2) std::cout << "Usage: IMPORT <filename.csv>\n";
-                        else importCSV(args[1]);
-                    }
+        bool cmdConnect(const std::vector<std::string>& args) {
+            if (crm.connect(args[1], std::stoi(args[2]), args[3])) {
+                is_connected = true;
+                std::cout << "OK Connected.\n";
+                return true;
+            }
+            std::cout << "ERR " << crm.getError() << "\n";
+            return false;
+        }
 
-                    else if (cmd == "EXPORT") {
-                        if (args.size() < 2) std::cout << "Usage: EXPORT <filename.csv>\n";
-                        else exportCSV(args[1]);
-                    }
+        static Lead parseLead(const std::vector<std::string>& args) {
+            Lead l;
+            l.name = args[2]; l.company = args[3]; l.value = std::stoi(args[4]);
+            return l;
+        }
 
-                    else if (cmd == "STATS") {
-                         const char* stages[] = { "New", "Contacted", "Won" };
-                         std::cout << "\n=== PIPELINE HEALTH ===\n";
-                         printRow("STAGE", "COUNT", "VALUE", "AVG");
-                         std::cout << "+" << std::string(66, '-') << "+\n";
-                         for (const char* stage : stages) {
-                             auto leads = crm.getLeadsByStage(stage);
-                             double val = 0; for(auto& l : leads) val += l.value;
-                             double avg = leads.empty() ? 0 : val/leads.size();
-                             printRow(stage, std::to_string(leads.size()), std::to_string((int)val), std::to_string((int)avg));
-                         }
-                         std::cout << "\n";
-                    }
+        static std::string joinFrom(const std::vector<std::string>& args, size_t first) {
+            std::string out;
+            for (size_t i = first; i < args.size(); i++) out += args[i] + " ";
+            return out;
+        }
+
+        bool cmdAdd(const std::vector<std::string>& args) {
+            Lead l = parseLead(args);
+            if (!crm.addLead(l)) { std::cout << "ERR Failed.\n"; return false; }
+            table_stale = true;
+            std::cout << "OK Lead Created.\n";
+            crm.publishEvent("CLI: New Lead " + l.name);
+            return true;
+        }
+
+        bool cmdTask(const std::vector<std::string>& args) {
+            fluxdb::Id id = std::stoull(args[1]);
+            if (!crm.addTask(id, joinFrom(args, 2), "")) { std::cout << "ERR Failed.\n"; return false; }
+            std::cout << "OK Task Added.\n";
+            crm.publishEvent("CLI: Task added to #" + std::to_string(id));
+            return true;
+        }
+
+        bool cmdPromote(const std::vector<std::string>& args) {
+            fluxdb::Id id = std::stoull(args[1]);
+            std::string newStage = args[2];
+
+            bool found = false;
+            const char* stages[] = { "New", "Contacted", "Won" };
+            Lead target;
+            for (const char* s : stages) {
+                auto leads = crm.getLeadsByStage(s);
+                for (auto& l : leads) { if (l.id == id) { target = l; found = true; break; } }
+                if (found) break;
+            }
+
+            if (found && crm.updateLeadStatus(target, newStage)) {
+                table_stale = true;
+                std::cout << "OK Promoted.\n";
+                crm.publishEvent("CLI: Promoted " + target.name + " to " + newStage);
+                return true;
+            }
+            std::cout << "ERR Failed.\n";
+            return false;
+        }
+
+        bool cmdImport(const std::vector<std::string>& args) {
+            table_stale = true;
+            return importLeads(args[1], args.size() > 2 && args[2] == "--dedupe");
+        }
+
+        bool cmdExport(const std::vector<std::string>& args) {
+            return exportLeads(args[1]);
+        }
+
+        bool cmdStats(const std::vector<std::string>&) {
+            const char* stages[] = { "New", "Contacted", "Won" };
+            std::cout << "\n=== PIPELINE HEALTH ===\n";
+            printRow("STAGE", "COUNT", "VALUE", "AVG");
+            std::cout << "+" << std::string(66, '-') << "+\n";
+            for (const char* stage : stages) {
+                auto leads = crm.getLeadsByStage(stage);
+                double val = 0; for (auto& l : leads) val += l.value;
+                double avg = leads.empty() ? 0 : val / leads.size();
+                printRow(stage, std::to_string(leads.size()), std::to_string((int)val), std::to_string((int)avg));
+            }
+            std::cout << "\n";
+            return true;
+        }
+
+        bool cmdList(const std::vector<std::string>& args) {
+            if (hasFlags(args)) {
+                listQuery(args);
+                return true;
+            }
+            std::string stage = (args.size() > 1) ? args[1] : "New";
+            auto leads = crm.getLeadsByStage(stage);
+            printRow("ID", "NAME", "COMPANY", "VALUE");
+            std::cout << "--------------------------------------------------------\n";
+            for (auto& l : leads) printRow(std::to_string(l.id), l.name, l.company, std::to_string(l.value));
+            std::cout << "Total: " << leads.size() << "\n";
+            return true;
+        }
+
+        bool cmdGoal(const std::vector<std::string>& args) {
+            int amount;
+            try { amount = std::stoi(args[1]); } catch (...) { std::cout << "ERR Invalid number.\n"; return false; }
+            if (crm.setPerformanceGoal(amount)) {
+                std::cout << "OK Performance goal updated to $" << amount << "\n";
+                crm.publishEvent("CLI: Goal updated to $" + std::to_string(amount));
+                return true;
+            }
+            std::cout << "ERR Failed to update goal.\n";
+            return false;
+        }
+
+        bool cmdNodes(const std::vector<std::string>&) {
+            for (const auto& n : crm.getNodeStats())
+                std::cout << std::left << std::setw(24) << n.name << (n.ok ? std::to_string(n.documents) : "?") << " records\n";
+            return true;
+        }
+
+        bool cmdIndexes(const std::vector<std::string>&) {
+            auto indexes = crm.getIndexes();
+            if (indexes.empty()) std::cout << "No indexes (server without INDEX support?)\n";
+            for (const auto& fields : indexes) {
+                for (size_t i = 0; i < fields.size(); i++) std::cout << (i ? " + " : "") << fields[i];
+                std::cout << "\n";
+            }
+            return true;
+        }
+
+        bool cmdNode(const std::vector<std::string>& args) {
+            std::string op = args[1];
+            for (auto& c : op) c = toupper(c);
+            long long moved = -1;
+            if (op == "ADD") moved = crm.addNode(args[2]);
+            else if (op == "DROP") moved = crm.removeNode(args[2]);
+            else { std::cout << "Usage: NODE ADD|DROP <host:port>\n"; return false; }
+
+            if (moved < 0) { std::cout << "ERR Node change failed.\n"; return false; }
+            table_stale = true;
+            std::cout << "OK Rebalanced, " << moved << " records moved.\n";
+            return true;
+        }
 
-                    else if (cmd == "LIST") {
-                        std::string stage = (args.size() > 1) ? args[1] : "New";
-                        auto leads = crm.getLeadsByStage(stage);
-                        printRow("ID", "NAME", "COMPANY", "VALUE");
-                        std::cout << "--------------------------------------------------------\n";
-                        for(auto& l : leads) printRow(std::to_string(l.id), l.name, l.company, std::to_string(l.value));
-                        std::cout << "Total: " << leads.size() << "\n";
+        // DEDUPE [--threshold <0..1>] [--merge]: groups of near-identical leads.
+        // --merge keeps the oldest lead of each group with the furthest stage and
+        // the highest value, moves the others' tasks and notes onto it once that
+        // update is in, then deletes the others.
+        bool cmdDedupe(const std::vector<std::string>& args) {
+            double threshold = Query::DuplicateIndex::DEFAULT_THRESHOLD;
+            bool merge = false;
+            for (size_t i = 1; i < args.size(); i++) {
+                if (args[i] == "--threshold" && i + 1 < args.size()) threshold = std::stod(args[++i]);
+                else if (args[i] == "--merge") merge = true;
+                else { std::cout << "Usage: DEDUPE [--threshold <0..1>] [--merge]\n"; return false; }
+            }
+
+            auto t0 = std::chrono::steady_clock::now();
+            std::vector<Lead> leads = crm.getAllLeads();
+            auto sigs = Query::DuplicateIndex::signatures(leads);
+            auto groups = Query::DuplicateIndex::clusters(sigs, threshold);
+            double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+
+            // The oldest lead of a group is kept. Groups are chained pairs, so
+            // only members that match the kept lead itself are merged into it;
+            // the rest (marked ~) are left alone.
+            struct Merge {
+                Lead keep;
+                std::vector<fluxdb::Id> drop;
+                bool ok = true;
+            };
+            auto rank = [](const std::string& stage) { return stage == "Won" ? 2 : stage == "Contacted" ? 1 : 0; };
+            auto older = [&](uint32_t a, uint32_t b) {
+                const Lead &x = leads[a], &y = leads[b];
+                return x.created_at != y.created_at ? x.created_at < y.created_at : x.id < y.id;
+            };
+            std::vector<Merge> merges;
+            size_t extra = 0, chained = 0;
+            for (size_t g = 0; g < groups.size(); g++) {
+                std::vector<uint32_t> rows = groups[g];
+                std::sort(rows.begin(), rows.end(), older);
+
+                Merge m;
+                m.keep = leads[rows[0]];
+                if (g < 20) std::cout << "Group " << g + 1 << ":\n";
+                for (size_t i = 0; i < rows.size(); i++) {
+                    const Lead& l = leads[rows[i]];
+                    bool direct = i == 0 || Query::DuplicateIndex::similar(sigs[rows[0]], sigs[rows[i]], threshold);
+                    if (g < 20) printRow((direct ? "" : "~") + std::to_string(l.id), l.name, l.company, std::to_string(l.value));
+                    if (i == 0) continue;
+                    if (!direct) { chained++; continue; }
+                    m.keep.value = std::max(m.keep.value, l.value);
+                    if (rank(l.status) > rank(m.keep.status)) m.keep.status = l.status;
+                    m.drop.push_back(l.id);
+                }
+                extra += m.drop.size();
+                if (!m.drop.empty()) merges.push_back(std::move(m));
+            }
+            if (groups.size() > 20) std::cout << "... " << groups.size() - 20 << " more groups\n";
+            std::cout << groups.size() << " groups, " << extra << " duplicates among " << leads.size() << " leads ("
+                      << std::fixed << std::setprecision(1) << ms << " ms)\n" << std::defaultfloat;
+            if (chained) std::cout << chained << " more (~) only match through another member and are not merged.\n";
+
+            if (!merge || merges.empty()) return true;
+            table_stale = true;
+
+            // Pipelined in chunks; op_merge[i] is the merge ops[i] belongs to
+            std::vector<fluxdb::BatchOp> ops;
+            std::vector<size_t> op_merge;
+            size_t failed = 0;
+            auto flush = [&]() {
+                size_t done = 0;
+                for (size_t i = 0; i < ops.size(); i += IMPORT_BATCH) {
+                    size_t end = std::min(ops.size(), i + IMPORT_BATCH);
+                    std::vector<fluxdb::BatchOp> chunk(ops.begin() + i, ops.begin() + end);
+                    auto results = crm.runBatch(chunk);
+                    for (size_t j = 0; j < results.size(); j++) {
+                        if (results[j].ok) { done++; continue; }
+                        failed++;
+                        merges[op_merge[i + j]].ok = false;
                     }
+                }
+                ops.clear();
+                op_merge.clear();
+                return done;
+            };
 
-                    else if (cmd == "GOAL") {
-                        if (args.size() < 2) { 
-                            std::cout << "Usage: GOAL <amount>\n";
-                            continue; 
-                        }
-                        try {
-                            int amount = std::stoi(args[1]);
-                            if (crm.setPerformanceGoal(amount)) {
-                                std::cout << "OK Performance goal updated to $" << amount << "\n";
-                                crm.publishEvent("CLI: Goal updated to $" + std::to_string(amount));
-                            } else {
-                                std::cout << "ERR Failed to update goal.\n";
-                            }
-                        } catch (...) { std::cout << "ERR Invalid number.\n"; }
+            // 1. The kept leads take the best stage and value
+            for (size_t k = 0; k < merges.size(); k++) {
+                ops.push_back(CRMSystem::batchUpdateLead(merges[k].keep));
+                op_merge.push_back(k);
+            }
+            flush();
+
+            // 2. Tasks and notes of the duplicates move to the kept lead
+            std::vector<fluxdb::Id> children;
+            for (size_t k = 0; k < merges.size(); k++) {
+                if (!merges[k].ok) continue;
+                for (fluxdb::Id id : merges[k].drop) {
+                    if (!crm.getChildIds(id, children)) { merges[k].ok = false; failed++; break; }
+                    for (fluxdb::Id child : children) {
+                        ops.push_back(CRMSystem::batchReparent(child, merges[k].keep.id));
+                        op_merge.push_back(k);
                     }
+                }
+            }
+            flush();
+
+            // 3. Only then are the duplicates deleted
+            for (size_t k = 0; k < merges.size(); k++) {
+                if (!merges[k].ok) continue;
+                for (fluxdb::Id id : merges[k].drop) {
+                    ops.push_back(CRMSystem::batchDelete(id));
+                    op_merge.push_back(k);
+                }
+            }
+            size_t removed = flush(), merged = 0;
+            for (const Merge& m : merges) merged += m.ok;
+            if (removed) crm.publishEvent("CLI: Merged " + std::to_string(removed) + " duplicate leads");
+
+            if (failed) {
+                std::cout << "ERR Merge: " << failed << " writes failed; " << merges.size() - merged
+                          << " groups not fully merged, " << removed << " leads removed.\n";
+                return false;
+            }
+            std::cout << "OK Merged " << merged << " groups, removed " << removed << " leads.\n";
+            return true;
+        }
+
+        // FORECAST [--trials <n>] [--reload]: expected revenue per stage and the
+        // P10-P90 band of the total. --reload refetches leads changed elsewhere.
+        bool cmdForecast(const std::vector<std::string>& args) {
+            int trials = Query::Forecaster::DEFAULT_TRIALS;
+            bool reload = false;
+            for (size_t i = 1; i < args.size(); i++) {
+                if (args[i] == "--trials" && i + 1 < args.size()) trials = std::stoi(args[++i]);
+                else if (args[i] == "--reload") reload = true;
+                else { std::cout << "Usage: FORECAST [--trials <n>] [--reload]\n"; return false; }
+            }
+
+            Query::ForecastResult f = crm.getForecast(reload, trials);
+            if (f.trials == 0) { std::cout << "ERR " << crm.getError() << "\n"; return false; }
+
+            const char* stages[] = { "New", "Contacted", "Won" };
+            printRow("STAGE", "LEADS", "EXPECTED", "WIN %");
+            std::cout << "--------------------------------------------------------\n";
+            for (int s = 0; s < Query::FORECAST_STAGES; s++) {
+                std::ostringstream rate;
+                rate << std::fixed << std::setprecision(1) << f.win_rate[s] * 100.0;
+                printRow(stages[s], std::to_string(f.count[s]), "$" + std::to_string((long long)f.expected[s]), rate.str());
+            }
+            std::cout << "Forecast: $" << (long long)f.expected_total << "  80% band: $" << (long long)f.low_total
+                      << " - $" << (long long)f.high_total << "  (" << f.trials << " trials, " << std::fixed
+                      << std::setprecision(1) << f.compute_ms << " ms)\n" << std::defaultfloat;
+            return true;
+        }
+
+        // NOTES SEARCH <words...> [--limit <n>]
+        bool cmdNotes(const std::vector<std::string>& args) {
+            std::string op = args[1];
+            for (auto& c : op) c = toupper(c);
+            if (op != "SEARCH") { std::cout << "Usage: NOTES SEARCH <words> [--limit <n>]\n"; return false; }
+
+            std::string words;
+            size_t limit = 20;
+            for (size_t i = 2; i < args.size(); i++) {
+                if (args[i] == "--limit" && i + 1 < args.size()) limit = std::stoul(args[++i]);
+                else words += args[i] + " ";
+            }
+
+            Query::NoteSearchResult result = crm.searchNotes(words, limit);
+            std::cout << "| " << std::left << std::setw(6) << "LEAD" << " | " << std::setw(7) << "SCORE" << " | NOTE\n";
+            std::cout << "--------------------------------------------------------\n";
+            for (const auto& h : result.hits) {
+                std::cout << "| " << std::left << std::setw(6) << h.parent_id << " | " << std::setw(7)
+                          << std::fixed << std::setprecision(2) << h.score << std::defaultfloat << " | " << *crm.noteText(h.id) << "\n";
+            }
+            std::cout << "Shown: " << result.hits.size() << "  Matched: " << result.matched
+                      << "  (" << std::fixed << std::setprecision(3) << result.search_ms << " ms)\n";
+            std::cout << std::defaultfloat;
+            return true;
+        }
+
+        // --- BATCH FORMS ---
+        // Pipelinable commands turn into one BatchOp each; the reply line is
+        // printed once the batch is flushed.
+
+        void queueAdd(const std::vector<std::string>& args, fluxdb::BatchOp& op) {
+            op = CRMSystem::batchAddLead(parseLead(args));
+        }
+
+        void queueTask(const std::vector<std::string>& args, fluxdb::BatchOp& op) {
+            op = CRMSystem::batchAddTask(std::stoull(args[1]), joinFrom(args, 2), "");
+        }
+
+        void queuePromote(const std::vector<std::string>& args, fluxdb::BatchOp& op) {
+            op = CRMSystem::batchSetStatus(std::stoull(args[1]), args[2]);
+        }
+
+        // --- DISPATCH TABLE ---
+
+        struct Command {
+            size_t min_args;        // including the command word
+            const char* usage;
+            bool needs_connection;
+            bool (CLIHost::*run)(const std::vector<std::string>&);
+            void (CLIHost::*queue)(const std::vector<std::string>&, fluxdb::BatchOp&);
+            const char* ok_reply;   // printed for a successful queued command
+        };
 
-                    else {
-                        std::cout << "ERR Unknown command '" << cmd << "'. Type HELP.\n";
+        static const std::unordered_map<std::string, Command>& commands() {
+            static const std::unordered_map<std::string, Command> table = {
+                { "EXIT",    { 1, "EXIT", false, &CLIHost::cmdExit, nullptr, nullptr } },
+                { "HELP",    { 1, "HELP", false, &CLIHost::cmdHelp, nullptr, nullptr } },
+                { "CONNECT", { 4, "CONNECT <ip> <port> <pass>", false, &CLIHost::cmdConnect, nullptr, nullptr } },
+                { "ADD",     { 5, "ADD <stage> <name> <company> <value>", true, &CLIHost::cmdAdd, &CLIHost::queueAdd, "OK Lead Created." } },
+                { "TASK",    { 3, "TASK <id> <desc>", true, &CLIHost::cmdTask, &CLIHost::queueTask, "OK Task Added." } },
+                { "PROMOTE", { 3, "PROMOTE <id> <stage>", true, &CLIHost::cmdPromote, &CLIHost::queuePromote, "OK Promoted." } },
+                { "IMPORT",  { 2, "IMPORT <file.csv|.jsonl|.flxs> [--dedupe]", true, &CLIHost::cmdImport, nullptr, nullptr } },
+                { "EXPORT",  { 2, "EXPORT <file.csv|.jsonl|.flxs>", true, &CLIHost::cmdExport, nullptr, nullptr } },
+                { "STATS",   { 1, "STATS", true, &CLIHost::cmdStats, nullptr, nullptr } },
+                { "LIST",    { 1, "LIST [stage]", true, &CLIHost::cmdList, nullptr, nullptr } },
+                { "GOAL",    { 2, "GOAL <amount>", true, &CLIHost::cmdGoal, nullptr, nullptr } },
+                { "NODES",   { 1, "NODES", true, &CLIHost::cmdNodes, nullptr, nullptr } },
+                { "NODE",    { 3, "NODE ADD|DROP <host:port>", true, &CLIHost::cmdNode, nullptr, nullptr } },
+                { "INDEXES", { 1, "INDEXES", true, &CLIHost::cmdIndexes, nullptr, nullptr } },
+                { "DEDUPE",  { 1, "DEDUPE [--threshold <0..1>] [--merge]", true, &CLIHost::cmdDedupe, nullptr, nullptr } },
+                { "FORECAST", { 1, "FORECAST [--trials <n>] [--reload]", true, &CLIHost::cmdForecast, nullptr, nullptr } },
+                { "NOTES",   { 3, "NOTES SEARCH <words> [--limit <n>]", true, &CLIHost::cmdNotes, nullptr, nullptr } },
+            };
+            return table;
+        }
+
+        // Resolves a line to its table entry, printing the reason on failure
+        const Command* lookup(const std::vector<std::string>& args, std::string& cmd) {
+            cmd = args[0];
+            for (auto& c : cmd) c = toupper(c);
+
+            auto it = commands().find(cmd);
+            if (it == commands().end()) { std::cout << "ERR Unknown command '" << cmd << "'. Type HELP.\n"; return nullptr; }
+            if (it->second.needs_connection && !is_connected) { std::cout << "ERR Not connected.\n"; return nullptr; }
+            if (args.size() < it->second.min_args) { std::cout << "Usage: " << it->second.usage << "\n"; return nullptr; }
+            return &it->second;
+        }
+
+        bool execute(const std::vector<std::string>& args) {
+            std::string cmd;
+            const Command* c = lookup(args, cmd);
+            if (!c) return false;
+            try {
+                return (this->*c->run)(args);
+            } catch (const std::exception& e) {
+                std::cout << "ERR " << e.what() << "\n";
+                return false;
+            }
+        }
+
+        // --- BATCH MODE ---
+
+        struct Queued {
+            size_t line;
+            const Command* command;
+        };
+
+        std::vector<fluxdb::BatchOp> batch_ops;
+        std::vector<Queued> batch_queued;
+        size_t batch_done = 0;
+        size_t batch_failed = 0;
+        size_t first_failed_line = 0;
+
+        void noteFailure(size_t line) {
+            batch_failed++;
+            if (!first_failed_line) first_failed_line = line;
+        }
+
+        // Sends the queued writes and prints their replies in script order.
+        // Returns false if any of them failed.
+        bool flushBatch() {
+            if (batch_ops.empty()) return true;
+            std::vector<fluxdb::BatchResult> results = crm.runBatch(batch_ops);
+
+            bool ok = true;
+            for (size_t i = 0; i < batch_queued.size(); i++) {
+                if (results[i].ok) {
+                    std::cout << batch_queued[i].command->ok_reply << "\n";
+                } else {
+                    std::cout << "ERR line " << batch_queued[i].line << ": failed.\n";
+                    noteFailure(batch_queued[i].line);
+                    ok = false;
+                }
+            }
+            batch_done += batch_queued.size();
+            table_stale = true;
+            batch_ops.clear();
+            batch_queued.clear();
+            return ok;
+        }
+
+    public:
+        // Commands queued before a pipelined flush
+        static const size_t BATCH_FLUSH = 512;
+
+        void run() {
+            std::cout << "FluxCRM (CLI Mode)\nType 'HELP' for commands.\n";
+
+            while (running) {
+                std::cout << (is_connected ? "flux> " : "(offline)> ");
+                std::string line;
+                if (!std::getline(std::cin, line)) break;
+
+                std::vector<std::string> args = tokenize(line);
+                if (args.empty()) continue;
+                execute(args);
+            }
+        }
+
+        // Runs a script: one command per line, '#' starts a comment.
+        // ADD/TASK/PROMOTE are pipelined in groups of BATCH_FLUSH; any other
+        // command first flushes what is queued, so output stays in script order.
+        // stop_on_error halts at the first failure; queued commands that were
+        // already sent with it still report their results.
+        // Returns the process exit code.
+        int runBatch(std::istream& in, bool stop_on_error) {
+            std::ios::sync_with_stdio(false);
+            auto started = std::chrono::steady_clock::now();
+            std::string line;
+            size_t line_no = 0;
+            bool stopped = false;
+
+            while (running && !stopped && std::getline(in, line)) {
+                line_no++;
+                std::vector<std::string> args = tokenize(line);
+                if (args.empty() || args[0][0] == '#') continue;
+
+                std::string cmd = args[0];
+                for (auto& ch : cmd) ch = toupper(ch);
+                auto it = commands().find(cmd);
+                const Command* c = (it != commands().end()) ? &it->second : nullptr;
+
+                if (c && c->queue && is_connected && args.size() >= c->min_args) {
+                    fluxdb::BatchOp op;
+                    std::string error;
+                    try { (this->*c->queue)(args, op); } catch (const std::exception& e) { error = e.what(); }
+
+                    if (error.empty()) {
+                        batch_ops.push_back(std::move(op));
+                        batch_queued.push_back({ line_no, c });
+                        if (batch_ops.size() >= BATCH_FLUSH && !flushBatch() && stop_on_error) stopped = true;
+                        continue;
                     }
+                    if (!flushBatch() && stop_on_error) { stopped = true; break; }
+                    std::cout << "ERR line " << line_no << ": " << error << "\n";
+                    batch_done++;
+                    noteFailure(line_no);
+                    if (stop_on_error) stopped = true;
+                    continue;
+                }
 
-                } catch (const std::exception& e) { std::cout << "ERR " << e.what() << "\n"; }
+                // Everything else runs synchronously after the queued writes land
+                if (!flushBatch() && stop_on_error) { stopped = true; break; }
+                batch_done++;
+                if (!execute(args)) {
+                    noteFailure(line_no);
+                    if (stop_on_error) stopped = true;
+                }
             }
+            flushBatch();
+
+            double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count();
+            if (batch_done > 0 && is_connected) crm.publishEvent("CLI: Batch applied " + std::to_string(batch_done) + " commands");
+            std::cout << (batch_failed ? "ERR" : "OK") << " Batch: " << batch_done << " commands, " << batch_failed << " failed"
+                      << (stopped ? ", stopped after line " + std::to_string(first_failed_line) : std::string()) << " ("
+                      << std::fixed << std::setprecision(2) << seconds << " s)\n";
+            std::cout.flush();
+            return batch_failed ? 1 : 0;
         }
     };
 }
@@ -2,14 +2,29 @@
 #define CRM_CORE_HPP
 
 #include "../vendor/fluxdb/fluxdb_client.hpp"
+#include "../vendor/fluxdb/sharded_client.hpp"
+#include "../vendor/fluxdb/publish_queue.hpp"
+#include "event_ring.hpp"
+#include "io/event_journal.hpp"
+#include "query/notes_index.hpp"
+#include "query/forecast.hpp"
 
 #include <vector>
 #include <string>
-#include <deque>
+#include <string_view>
 #include <mutex>
 #include <atomic>
 #include <thread>
 #include <ctime>
+#include <functional>
+#include <unordered_map>
+#include <unordered_set>
+#include <condition_variable>
+#include <deque>
+#include <list>
+#include <memory>
+#include <future>
+#include <algorithm>
 
 // --- DATA MODELS ---
 
@@ -19,29 +34,163 @@ struct Lead {
     std::string company;
     std::string status;
     int value = 0;
+    int64_t created_at = 0;     // unix seconds; 0 for leads written before it was recorded
 };
 
 struct Task {
-    int id = 0;
-    int parent_id = 0;
+    fluxdb::Id id = 0;
+    fluxdb::Id parent_id = 0;
     std::string description;
     bool is_done = false;
     std::string due_date;
 };
 
 struct Interaction {
-    int id = 0;
-    int parent_id = 0;
+    fluxdb::Id id = 0;
+    fluxdb::Id parent_id = 0;
     std::string note;
 };
 
+struct LeadDetails {
+    std::vector<Task> tasks;
+    std::vector<Interaction> interactions;
+};
+
+struct StageSummary {
+    bool ok = false;
+    size_t count = 0;
+    double value = 0.0;
+};
+
 // --- CONTROLLER ---
 
 class CRMSystem {
 private:
-    std::unique_ptr<fluxdb::FluxDBClient> db;
+    std::unique_ptr<fluxdb::ShardedClient> db;
     std::string last_error;
 
+    // crm_events notifications, sent in the background on their own
+    // connection to the first node (where the ticker subscribes)
+    std::unique_ptr<fluxdb::PublishQueue> events;
+
+    // Events this client published that the ticker has not echoed back yet,
+    // oldest first; lets the UI skip reloads for its own edits
+    std::mutex own_lock;
+    std::deque<std::string> own_events;
+    static const size_t MAX_OWN_EVENTS = 64;
+
+    void rememberOwn(const std::string& msg) {
+        std::lock_guard<std::mutex> lk(own_lock);
+        if (own_events.size() >= MAX_OWN_EVENTS) own_events.pop_front();
+        own_events.push_back(msg);
+    }
+
+    void forgetOwn(const std::string& msg) {
+        std::lock_guard<std::mutex> lk(own_lock);
+        auto it = std::find(own_events.rbegin(), own_events.rend(), msg);
+        if (it != own_events.rend()) own_events.erase(std::next(it).base());
+    }
+
+    // Queues of earlier connections, finishing their drain off the caller's
+    // thread; waited for when the CRMSystem goes away
+    std::vector<std::future<void>> retiring;
+
+    void retireEvents() {
+        retiring.erase(std::remove_if(retiring.begin(), retiring.end(), [](std::future<void>& f) {
+            return f.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+        }), retiring.end());
+        if (!events) return;
+        std::shared_ptr<fluxdb::PublishQueue> old(std::move(events));
+        retiring.push_back(std::async(std::launch::async, [old]() mutable { old.reset(); }));
+    }
+
+    // Full-text index of interaction notes, loaded on the first search and
+    // then kept current by addInteraction/clearInteractions
+    Query::NotesIndex notes;
+    bool notes_loaded = false;
+
+    // Every lead's stage and value for the revenue forecast, loaded on first
+    // use and then kept current by this client's own lead writes
+    Query::Forecaster forecaster;
+    bool forecast_loaded = false;
+
+    // Query features of the connected server, probed on first use:
+    // -1 not known yet, 0 missing, 1 supported
+    int paging_support = -1;
+    int contains_support = -1;
+    int keyset_support = -1;    // "_id": {"$gt": n}; learned by scanLeads
+
+    // --- PREPARED QUERIES ---
+    // The hot reads; their fixed parts are serialized once, per-call values are spliced in
+    const fluxdb::PreparedQuery all_leads_query = fluxdb::PreparedQuery().where("type", "lead");
+    const fluxdb::PreparedQuery stage_query = fluxdb::PreparedQuery().where("type", "lead").param("status", fluxdb::Type::String);
+    const fluxdb::PreparedQuery task_query = fluxdb::PreparedQuery().where("type", "task").param("parent_id", fluxdb::Type::Int);
+    const fluxdb::PreparedQuery open_task_query = fluxdb::PreparedQuery().where("type", "task").where("done", false);
+    const fluxdb::PreparedQuery interaction_query = fluxdb::PreparedQuery().where("type", "interaction").param("parent_id", fluxdb::Type::Int);
+    const fluxdb::PreparedQuery all_interactions_query = fluxdb::PreparedQuery().where("type", "interaction");
+    const fluxdb::PreparedQuery goal_query = fluxdb::PreparedQuery().where("type", "config").where("key", "goal");
+
+    // --- SCHEMA ---
+    // Indexes behind those reads, ensured on connect. Queries on just `type`
+    // (all leads, open tasks by type+done) use the leading fields.
+    const std::vector<std::vector<std::string>> schema_indexes = {
+        { "type", "status" },
+        { "type", "parent_id" },
+        { "type", "done", "due_date" },
+    };
+
+    static Lead toLead(const fluxdb::Document& doc, const std::string& stage) {
+        Lead l;
+        if (doc.count("_id"))     l.id = doc.at("_id")->asInt();
+        if (doc.count("name"))    l.name = doc.at("name")->asString();
+        if (doc.count("company")) l.company = doc.at("company")->asString();
+        if (doc.count("value"))   l.value = (int)doc.at("value")->asInt();
+        if (doc.count("created_at")) l.created_at = doc.at("created_at")->asInt();
+        l.status = stage;
+        return l;
+    }
+
+    // A stage's leads whose name or company contains `text` (case-sensitive)
+    static fluxdb::Document searchQuery(const std::string& stage, const std::string& text) {
+        fluxdb::Document spec;
+        spec["fields"] = std::make_shared<fluxdb::Value>(fluxdb::Array{
+            std::make_shared<fluxdb::Value>("name"), std::make_shared<fluxdb::Value>("company") });
+        spec["text"] = std::make_shared<fluxdb::Value>(text);
+
+        fluxdb::Document q;
+        q["type"] = std::make_shared<fluxdb::Value>("lead");
+        if (!stage.empty()) q["status"] = std::make_shared<fluxdb::Value>(stage);
+        q["$contains"] = std::make_shared<fluxdb::Value>(std::move(spec));
+        return q;
+    }
+
+    static fluxdb::Document leadDocument(const Lead& lead) {
+        fluxdb::Document doc;
+        doc["type"] = std::make_shared<fluxdb::Value>("lead");
+        doc["name"] = std::make_shared<fluxdb::Value>(lead.name);
+        doc["company"] = std::make_shared<fluxdb::Value>(lead.company);
+        doc["status"] = std::make_shared<fluxdb::Value>(lead.status.empty() ? "New" : lead.status);
+        doc["value"] = std::make_shared<fluxdb::Value>((int64_t)lead.value);
+        return doc;
+    }
+
+    // Inserts also stamp the creation time; updates leave it alone
+    static fluxdb::Document newLeadDocument(const Lead& lead) {
+        fluxdb::Document doc = leadDocument(lead);
+        doc["created_at"] = std::make_shared<fluxdb::Value>((int64_t)time(nullptr));
+        return doc;
+    }
+
+    static fluxdb::Document taskDocument(fluxdb::Id lead_id, const std::string& desc, const std::string& date) {
+        fluxdb::Document doc;
+        doc["type"] = std::make_shared<fluxdb::Value>("task");
+        doc["parent_id"] = std::make_shared<fluxdb::Value>((int64_t)lead_id);
+        doc["description"] = std::make_shared<fluxdb::Value>(desc);
+        doc["due_date"] = std::make_shared<fluxdb::Value>(date);
+        doc["done"] = std::make_shared<fluxdb::Value>(false);
+        return doc;
+    }
+
     std::string getToday() {
         time_t now = time(nullptr);
         tm local{};
@@ -52,12 +201,43 @@ private:
         return std::string(buf);
     }
 
+    // Mirrors a successful batch write into the forecast snapshot
+    void applyToForecast(const fluxdb::BatchOp& op, fluxdb::Id inserted) {
+        auto field = [&](const char* name) { auto it = op.doc.find(name); return it != op.doc.end() ? it->second : nullptr; };
+        auto type = field("type"), status = field("status"), value = field("value");
+
+        if (op.kind == fluxdb::BatchOp::Kind::Remove) {
+            forecaster.remove(op.id);
+        } else if (op.kind == fluxdb::BatchOp::Kind::Insert) {
+            if (type && type->asString() == "lead")
+                forecaster.upsert(inserted, status ? status->asString() : "New", value ? (int)value->asInt() : 0);
+        } else if (op.kind == fluxdb::BatchOp::Kind::Update && (status || value)) {
+            std::string stage = status ? status->asString() : std::string();
+            int v = value ? (int)value->asInt() : 0;
+            forecaster.patch(op.id, status ? &stage : nullptr, value ? &v : nullptr);
+        }
+    }
+
 public:
     // --- CONNECTION ---
 
+    // ip may list several nodes: "10.0.0.1:8080,10.0.0.2:8080" (port is the default)
     bool connect(const std::string& ip, int port, const std::string& pass) {
         try {
-            db = std::make_unique<fluxdb::FluxDBClient>(ip, port);
+            auto nodes = fluxdb::parseNodeList(ip, port);
+            if (nodes.empty()) {
+                last_error = "No server address";
+                return false;
+            }
+            retireEvents(); // still sends what the previous connection had queued
+            db = std::make_unique<fluxdb::ShardedClient>(nodes);
+            notes.clear();
+            notes_loaded = false;
+            forecaster.clear();
+            forecast_loaded = false;
+            paging_support = -1;
+            contains_support = -1;
+            keyset_support = -1;
 
             if (!db->auth(pass)) {
                 last_error = "Auth Failed";
@@ -69,6 +249,11 @@ public:
                 return false;
             }
 
+            // Servers without INDEX still work, just with full scans
+            for (const auto& fields : schema_indexes) db->createIndex(fields);
+
+            events = std::make_unique<fluxdb::PublishQueue>(nodes[0].host, nodes[0].port, pass);
+
             return true;
         } catch (const std::exception& e) {
             last_error = e.what();
@@ -77,6 +262,31 @@ public:
     }
 
     bool isConnected() const { return db != nullptr; }
+
+    // --- CLUSTER ---
+
+    // Adds "host:port" as a shard and moves its share of records onto it.
+    // Returns records moved, or -1.
+    long long addNode(const std::string& address, int default_port = 8080) {
+        if (!db) return -1;
+        auto nodes = fluxdb::parseNodeList(address, default_port);
+        if (nodes.size() != 1) return -1;
+        try { return db->addNode(nodes[0]); } catch (...) { return -1; }
+    }
+
+    long long removeNode(const std::string& address) {
+        if (!db) return -1;
+        try { return db->removeNode(address); } catch (...) { return -1; }
+    }
+
+    std::vector<fluxdb::ShardedClient::NodeStats> getNodeStats() {
+        if (!db) return {};
+        try { return db->nodeStats(); } catch (...) { return {}; }
+    }
+    std::vector<std::vector<std::string>> getIndexes() {
+        if (!db) return {};
+        try { return db->listIndexes(); } catch (...) { return {}; }
+    }
     std::string getError() const { return last_error; }
 
     // --- LEADS ---
@@ -85,14 +295,8 @@ public:
         if (!db) return false;
 
         try {
-            fluxdb::Document doc;
-            doc["type"] = std::make_shared<fluxdb::Value>("lead");
-            doc["name"] = std::make_shared<fluxdb::Value>(lead.name);
-            doc["company"] = std::make_shared<fluxdb::Value>(lead.company);
-            doc["status"] = std::make_shared<fluxdb::Value>("New");
-            doc["value"] = std::make_shared<fluxdb::Value>((int64_t)lead.value);
-
-            db->insert(doc);
+            fluxdb::Id id = db->insert(newLeadDocument(lead));
+            if (forecast_loaded && id) forecaster.upsert(id, lead.status.empty() ? "New" : lead.status, lead.value);
             return true;
         } catch (...) {
             return false;
@@ -132,25 +336,145 @@ public:
         if (!db) return output;
 
         try {
-            fluxdb::Document query;
-            query["type"] = std::make_shared<fluxdb::Value>("lead");
-            query["status"] = std::make_shared<fluxdb::Value>(stage);
+            auto results = db->find(stage_query.bind({ stage }));
+            output.reserve(results.size());
+            for (const auto& doc : results) output.push_back(toLead(doc, stage));
+        } catch (...) {}
 
-            auto results = db->find(query);
+        return output;
+    }
+
+    // Every lead regardless of stage, for local queries
+    std::vector<Lead> getAllLeads() {
+        std::vector<Lead> output;
+        if (!db) return output;
+
+        try {
+            auto results = db->find(all_leads_query.bind({}));
+            output.reserve(results.size());
             for (const auto& doc : results) {
-                Lead l;
-                if (doc.count("_id"))     l.id = doc.at("_id")->asInt();
-                if (doc.count("name"))    l.name = doc.at("name")->asString();
-                if (doc.count("company")) l.company = doc.at("company")->asString();
-                if (doc.count("value"))   l.value = (int)doc.at("value")->asInt();
-                l.status = stage;
-                output.push_back(l);
+                std::string stage = doc.count("status") ? doc.at("status")->asString() : "";
+                output.push_back(toLead(doc, stage));
             }
         } catch (...) {}
 
         return output;
     }
 
+    // One window of a stage, in server order, optionally only the leads whose
+    // name or company contains `filter` (needs supportsSearch()). Used by LeadCursor.
+    std::vector<Lead> getLeadsByStage(const std::string& stage, size_t skip, size_t limit, const std::string& filter = "") {
+        std::vector<Lead> output;
+        if (!db) return output;
+
+        try {
+            auto results = filter.empty() ? db->find(stage_query.bind({ stage }), skip, limit)
+                                          : db->find(searchQuery(stage, filter), skip, limit);
+            output.reserve(results.size());
+            for (const auto& doc : results) output.push_back(toLead(doc, stage));
+        } catch (...) {}
+
+        return output;
+    }
+
+    // Streams a stage page by page, calling fn(const Lead&) per row, so memory
+    // stays flat however many leads there are. Pages are keyed by id where the
+    // server allows, so the last page costs what the first does; otherwise
+    // SKIP/LIMIT. False if the server failed midway.
+    template <typename Fn>
+    bool scanLeads(const std::string& stage, size_t page, Fn&& fn) {
+        if (!db) return false;
+
+        try {
+            if (keyset_support != 0) {
+                fluxdb::Document q;
+                q["type"] = std::make_shared<fluxdb::Value>("lead");
+                q["status"] = std::make_shared<fluxdb::Value>(stage);
+                fluxdb::ShardedClient::ScanCursor cursor;
+                bool any = false;
+                while (true) {
+                    auto results = db->scan(q, cursor, page);
+                    if (results.empty()) break;
+                    any = true;
+                    for (const auto& doc : results) fn(toLead(doc, stage));
+                }
+                if (any) keyset_support = 1;
+                if (keyset_support == 1) return true;
+
+                // Nothing back: an empty stage, or a server that reads $gt as
+                // a field no lead has. One plain row tells them apart.
+                if (db->find(stage_query.bind({ stage }), 0, 1).empty()) return true;
+                keyset_support = 0;
+            }
+
+            for (size_t skip = 0;; skip += page) {
+                auto results = db->find(stage_query.bind({ stage }), skip, page);
+                for (const auto& doc : results) fn(toLead(doc, stage));
+                // A short page is the last one; servers without SKIP/LIMIT send everything at once
+                if (results.size() != page) break;
+            }
+            return true;
+        } catch (const std::exception& e) {
+            last_error = e.what();
+            return false;
+        }
+    }
+
+    // Lead count and total value of a stage without fetching the leads, or of
+    // its leads matching `filter` (needs supportsSearch()).
+    // ok == false means the server has no COUNT support.
+    StageSummary getStageSummary(const std::string& stage, const std::string& filter = "") {
+        StageSummary summary;
+        if (!db) return summary;
+
+        try {
+            fluxdb::CountResult res = filter.empty() ? db->count(stage_query.bind({ stage }), "value")
+                                                     : db->count(searchQuery(stage, filter), "value");
+            summary.ok = res.ok;
+            summary.count = (size_t)res.count;
+            summary.value = res.sum;
+        } catch (...) {}
+
+        return summary;
+    }
+
+    // Whether FIND honours SKIP/LIMIT. Servers that ignore them send every
+    // match, so two one-row windows come back as the same row (or more than
+    // one). Needs two leads to tell; until then the answer is no, uncached.
+    bool supportsPaging() {
+        if (!db) return false;
+        if (paging_support >= 0) return paging_support == 1;
+
+        try {
+            auto first = db->find(all_leads_query.bind({}), 0, 1);
+            auto second = db->find(all_leads_query.bind({}), 1, 1);
+            if (first.size() > 1 || second.size() > 1) {
+                paging_support = 0;
+            } else if (first.size() == 1 && second.size() == 1) {
+                paging_support = first[0].at("_id")->asInt() != second[0].at("_id")->asInt() ? 1 : 0;
+            }
+        } catch (...) {}
+        return paging_support == 1;
+    }
+
+    // Whether queries understand $contains. A server without it compares the
+    // operator as an ordinary field, which no lead has, so an empty search
+    // matches nothing instead of every lead. Needs COUNT and at least one lead.
+    bool supportsSearch() {
+        if (!db) return false;
+        if (contains_support >= 0) return contains_support == 1;
+
+        try {
+            fluxdb::CountResult all = db->count(all_leads_query.bind({}));
+            if (!all.ok) {
+                contains_support = 0;
+            } else if (all.count > 0) {
+                contains_support = db->count(searchQuery("", "")).count == all.count ? 1 : 0;
+            }
+        } catch (...) {}
+        return contains_support == 1;
+    }
+
     bool updateLeadStatus(const Lead& lead, const std::string& newStatus) {
         if (!db) return false;
 
@@ -162,15 +486,19 @@ public:
             doc["value"] = std::make_shared<fluxdb::Value>((int64_t)lead.value);
             doc["status"] = std::make_shared<fluxdb::Value>(newStatus);
 
-            return db->update(lead.id, doc);
+            if (!db->update(lead.id, doc)) return false;
+            if (forecast_loaded) forecaster.upsert(lead.id, newStatus, lead.value);
+            return true;
         } catch (...) {
             return false;
         }
     }
 
-    bool deleteLead(int id) {
+    bool deleteLead(fluxdb::Id id) {
         if (!db) return false;
-        return db->remove(id);
+        if (!db->remove(id)) return false;
+        forecaster.remove(id);
+        return true;
     }
 
     double getWonRevenue() {
@@ -179,11 +507,7 @@ public:
         double total = 0.0;
 
         try {
-            fluxdb::Document query;
-            query["type"] = std::make_shared<fluxdb::Value>("lead");
-            query["status"] = std::make_shared<fluxdb::Value>("Won");
-
-            auto results = db->find(query);
+            auto results = db->find(stage_query.bind({ "Won" }));
             for (const auto& doc : results) {
                 if (doc.count("value")) {
                     total += doc.at("value")->asInt();
@@ -194,57 +518,142 @@ public:
         return total;
     }
 
+    // --- BATCHES ---
+    // Writes queued as BatchOps are sent pipelined by runBatch(); results come
+    // back in order. Used by the CLI --batch mode.
+
+    static fluxdb::BatchOp batchAddLead(const Lead& lead) {
+        fluxdb::BatchOp op;
+        op.kind = fluxdb::BatchOp::Kind::Insert;
+        op.doc = newLeadDocument(lead);
+        return op;
+    }
+
+    static fluxdb::BatchOp batchAddTask(fluxdb::Id lead_id, const std::string& desc, const std::string& date) {
+        fluxdb::BatchOp op;
+        op.kind = fluxdb::BatchOp::Kind::Insert;
+        op.doc = taskDocument(lead_id, desc, date);
+        return op;
+    }
+
+    static fluxdb::BatchOp batchSetStatus(fluxdb::Id id, const std::string& stage) {
+        fluxdb::BatchOp op;
+        op.kind = fluxdb::BatchOp::Kind::Update;
+        op.id = id;
+        op.doc["status"] = std::make_shared<fluxdb::Value>(stage);
+        return op;
+    }
+
+    static fluxdb::BatchOp batchUpdateLead(const Lead& lead) {
+        fluxdb::BatchOp op;
+        op.kind = fluxdb::BatchOp::Kind::Update;
+        op.id = lead.id;
+        op.doc = leadDocument(lead);
+        return op;
+    }
+
+    // Moves a task or interaction to another lead
+    static fluxdb::BatchOp batchReparent(fluxdb::Id child_id, fluxdb::Id lead_id) {
+        fluxdb::BatchOp op;
+        op.kind = fluxdb::BatchOp::Kind::Update;
+        op.id = child_id;
+        op.doc["parent_id"] = std::make_shared<fluxdb::Value>((int64_t)lead_id);
+        return op;
+    }
+
+    static fluxdb::BatchOp batchDelete(fluxdb::Id id) {
+        fluxdb::BatchOp op;
+        op.kind = fluxdb::BatchOp::Kind::Remove;
+        op.id = id;
+        return op;
+    }
+
+    std::vector<fluxdb::BatchResult> runBatch(const std::vector<fluxdb::BatchOp>& ops) {
+        if (!db) return std::vector<fluxdb::BatchResult>(ops.size());
+        try {
+            auto results = db->pipeline(ops);
+            if (forecast_loaded)
+                for (size_t i = 0; i < ops.size() && i < results.size(); i++)
+                    if (results[i].ok) applyToForecast(ops[i], results[i].id);
+            return results;
+        } catch (const std::exception& e) {
+            last_error = e.what();
+            return std::vector<fluxdb::BatchResult>(ops.size());
+        }
+    }
+
     // --- EVENTS ---
 
-    void publishEvent(const std::string& msg) {
-        if (db) db->publish("crm_events", msg);
+    // Queued, never waits for the server; false if the queue was full
+    bool publishEvent(const std::string& msg) {
+        if (!events) return false;
+        rememberOwn(msg); // before posting: the echo can beat post()'s return
+        if (events->post("crm_events", msg)) return true;
+        forgetOwn(msg);
+        return false;
+    }
+
+    // For callers that need delivery: resolves to the receiver count, or -1
+    std::future<int> publishEventAcked(const std::string& msg) {
+        if (events) {
+            rememberOwn(msg);
+            return events->postAcked("crm_events", msg);
+        }
+        std::promise<int> none;
+        none.set_value(-1);
+        return none.get_future();
+    }
+
+    // True (once) for a ticker event that echoes one of this client's own
+    // publishEvent() calls; anything else came from another client
+    bool isOwnEvent(std::string_view msg) {
+        std::lock_guard<std::mutex> lk(own_lock);
+        auto it = std::find(own_events.begin(), own_events.end(), msg);
+        if (it == own_events.end()) return false;
+        own_events.erase(it);
+        return true;
+    }
+
+    fluxdb::PublishStats getPublishStats() {
+        return events ? events->stats() : fluxdb::PublishStats{};
     }
 
     // --- TASKS ---
 
-    bool addTask(int lead_id, const std::string& desc, const std::string& date) {
+    bool addTask(fluxdb::Id lead_id, const std::string& desc, const std::string& date) {
         if (!db) return false;
 
         try {
-            fluxdb::Document doc;
-            doc["type"] = std::make_shared<fluxdb::Value>("task");
-            doc["parent_id"] = std::make_shared<fluxdb::Value>((int64_t)lead_id);
-            doc["description"] = std::make_shared<fluxdb::Value>(desc);
-            doc["due_date"] = std::make_shared<fluxdb::Value>(date);
-            doc["done"] = std::make_shared<fluxdb::Value>(false);
-
-            db->insert(doc);
+            db->insert(taskDocument(lead_id, desc, date));
             return true;
         } catch (...) {
             return false;
         }
     }
 
-    std::vector<Task> getTasks(int lead_id) {
+    static Task toTask(const fluxdb::Document& doc, fluxdb::Id lead_id) {
+        Task t;
+        if (doc.count("_id")) t.id = doc.at("_id")->asInt();
+        t.parent_id = lead_id;
+        if (doc.count("description")) t.description = doc.at("description")->asString();
+        if (doc.count("done")) t.is_done = doc.at("done")->asBool();
+        if (doc.count("due_date")) t.due_date = doc.at("due_date")->asString();
+        return t;
+    }
+
+    std::vector<Task> getTasks(fluxdb::Id lead_id) {
         std::vector<Task> list;
         if (!db) return list;
 
         try {
-            fluxdb::Document query;
-            query["type"] = std::make_shared<fluxdb::Value>("task");
-            query["parent_id"] = std::make_shared<fluxdb::Value>((int64_t)lead_id);
-
-            auto results = db->find(query);
-            for (const auto& doc : results) {
-                Task t;
-                if (doc.count("_id")) t.id = doc.at("_id")->asInt();
-                t.parent_id = lead_id;
-                if (doc.count("description")) t.description = doc.at("description")->asString();
-                if (doc.count("done")) t.is_done = doc.at("done")->asBool();
-                if (doc.count("due_date")) t.due_date = doc.at("due_date")->asString();
-                list.push_back(t);
-            }
+            auto results = db->find(task_query.bind({ lead_id }));
+            for (const auto& doc : results) list.push_back(toTask(doc, lead_id));
         } catch (...) {}
 
         return list;
     }
 
-    bool toggleTask(int task_id, bool new_state) {
+    bool toggleTask(fluxdb::Id task_id, bool new_state) {
         if (!db) return false;
 
         try {
@@ -263,11 +672,7 @@ public:
         std::string today = getToday();
 
         try {
-            fluxdb::Document query;
-            query["type"] = std::make_shared<fluxdb::Value>("task");
-            query["done"] = std::make_shared<fluxdb::Value>(false);
-
-            auto results = db->find(query);
+            auto results = db->find(open_task_query.bind({}));
             for (const auto& doc : results) {
                 if (!doc.count("due_date")) continue;
 
@@ -287,7 +692,7 @@ public:
 
     // --- INTERACTIONS ---
 
-    bool addInteraction(int lead_id, const std::string& note) {
+    bool addInteraction(fluxdb::Id lead_id, const std::string& note) {
         if (!db) return false;
 
         try {
@@ -295,35 +700,70 @@ public:
             doc["type"] = std::make_shared<fluxdb::Value>("interaction");
             doc["parent_id"] = std::make_shared<fluxdb::Value>((int64_t)lead_id);
             doc["note"] = std::make_shared<fluxdb::Value>(note);
-            db->insert(doc);
+            fluxdb::Id id = db->insert(doc);
+            if (!id) return false;
+            if (notes_loaded) notes.add(id, lead_id, note);
             return true;
         } catch (...) {
             return false;
         }
     }
 
-    std::vector<Interaction> getInteractions(int lead_id) {
+    // Ids of a lead's tasks and interactions. False if the server failed, so
+    // callers never act on part of the list.
+    bool getChildIds(fluxdb::Id lead_id, std::vector<fluxdb::Id>& out) {
+        out.clear();
+        if (!db) return false;
+
+        try {
+            for (const fluxdb::PreparedQuery* q : { &task_query, &interaction_query })
+                for (const auto& doc : db->find(q->bind({ lead_id })))
+                    if (doc.count("_id")) out.push_back(doc.at("_id")->asInt());
+            return true;
+        } catch (const std::exception& e) {
+            last_error = e.what();
+            return false;
+        }
+    }
+
+    static Interaction toInteraction(const fluxdb::Document& doc, fluxdb::Id lead_id) {
+        Interaction i;
+        if (doc.count("_id")) i.id = doc.at("_id")->asInt();
+        if (doc.count("note")) i.note = doc.at("note")->asString();
+        i.parent_id = lead_id;
+        return i;
+    }
+
+    std::vector<Interaction> getInteractions(fluxdb::Id lead_id) {
         std::vector<Interaction> list;
         if (!db) return list;
 
         try {
-            fluxdb::Document query;
-            query["type"] = std::make_shared<fluxdb::Value>("interaction");
-            query["parent_id"] = std::make_shared<fluxdb::Value>((int64_t)lead_id);
-
-            auto results = db->find(query);
-            for (const auto& doc : results) {
-                Interaction i;
-                if (doc.count("_id")) i.id = doc.at("_id")->asInt();
-                if (doc.count("note")) i.note = doc.at("note")->asString();
-                i.parent_id = lead_id;
-                list.push_back(i);
-            }
+            auto results = db->find(interaction_query.bind({ lead_id }));
+            for (const auto& doc : results) list.push_back(toInteraction(doc, lead_id));
         } catch (...) {}
 
         return list;
     }
-    int clearInteractions(int lead_id = -1) {
+
+    // Tasks and notes of one lead together. False if either read failed (not
+    // connected, error reply, lost connection), where getTasks() and
+    // getInteractions() would just look empty.
+    bool getDetails(fluxdb::Id lead_id, LeadDetails& out) {
+        if (!db) return false;
+
+        try {
+            uint64_t failures = db->findFailures();
+            out.tasks.clear();
+            out.interactions.clear();
+            for (const auto& doc : db->find(task_query.bind({ lead_id }))) out.tasks.push_back(toTask(doc, lead_id));
+            for (const auto& doc : db->find(interaction_query.bind({ lead_id }))) out.interactions.push_back(toInteraction(doc, lead_id));
+            return db->findFailures() == failures;
+        } catch (...) {
+            return false;
+        }
+    }
+    int clearInteractions(int64_t lead_id = -1) {
         if (!db) return 0; 
         int count = 0;
 
@@ -341,6 +781,7 @@ public:
                 if (doc.count("_id")) {
                     fluxdb::Id id = doc.at("_id")->asInt();
                     if (db->remove(id)) {
+                        notes.remove(id);
                         count++;
                     }
                 }
@@ -358,16 +799,65 @@ public:
         return count;
     }
 
+    // Ranked search over every lead's notes. The first search (or one with
+    // reload, after other clients' edits) loads the index with one FIND; later
+    // ones never touch the server.
+    Query::NoteSearchResult searchNotes(const std::string& query, size_t limit = 20, bool reload = false) {
+        if (!db) return {};
+
+        if (!notes_loaded || reload) {
+            try {
+                auto results = db->find(all_interactions_query.bind({}));
+                notes.clear();
+                for (const auto& doc : results) {
+                    if (!doc.count("_id") || !doc.count("note")) continue;
+                    fluxdb::Id parent = doc.count("parent_id") ? doc.at("parent_id")->asInt() : 0;
+                    notes.add(doc.at("_id")->asInt(), parent, doc.at("note")->asString());
+                }
+                notes_loaded = true;
+            } catch (const std::exception& e) {
+                last_error = e.what();
+                return {};
+            }
+        }
+        return notes.search(query, limit);
+    }
+
+    // Text of a note from the last searchNotes() hits; nullptr once it is gone
+    const std::string* noteText(fluxdb::Id id) const { return notes.text(id); }
+
+    // --- FORECAST ---
+
+    // Win-probability weighted revenue with Monte Carlo bands. The first call
+    // (or one with reload) fetches every lead; after that only this client's
+    // writes are applied, and an unchanged snapshot is not recomputed.
+    Query::ForecastResult getForecast(bool reload = false, int trials = Query::Forecaster::DEFAULT_TRIALS) {
+        if (!db) return {};
+
+        if (!forecast_loaded || reload) {
+            try {
+                auto results = db->find(all_leads_query.bind({}));
+                forecaster.clear();
+                for (const auto& doc : results) {
+                    if (!doc.count("_id") || !doc.count("status")) continue;
+                    int value = doc.count("value") ? (int)doc.at("value")->asInt() : 0;
+                    forecaster.upsert(doc.at("_id")->asInt(), doc.at("status")->asString(), value);
+                }
+                forecast_loaded = true;
+            } catch (const std::exception& e) {
+                last_error = e.what();
+                return {};
+            }
+        }
+        return forecaster.compute(trials);
+    }
+
     // --- CONFIGURATION ---
 
     bool setPerformanceGoal(int amount) {
         if (!db) return false;
         try {
-            fluxdb::Document query;
-            query["type"] = std::make_shared<fluxdb::Value>("config");
-            query["key"] = std::make_shared<fluxdb::Value>("goal");
-            
-            auto results = db->find(query);
+            auto results = db->find(goal_query.bind({}));
             
             fluxdb::Document doc;
             doc["type"] = std::make_shared<fluxdb::Value>("config");
@@ -391,11 +881,7 @@ public:
         if (!db) return 10000.0; 
 
         try {
-            fluxdb::Document query;
-            query["type"] = std::make_shared<fluxdb::Value>("config");
-            query["key"] = std::make_shared<fluxdb::Value>("goal");
-
-            auto results = db->find(query);
+            auto results = db->find(goal_query.bind({}));
             if (!results.empty() && results[0].count("val")) {
                 return (double)results[0].at("val")->asInt();
             }
@@ -405,42 +891,372 @@ public:
     }
 };
 
+// --- LEAD CURSOR ---
+// Random access over one stage, fetched in pages of LIMIT/SKIP windows as rows
+// become visible. Keeps at most max_pages pages, evicting the ones farthest
+// from the last access. Falls back to one full FIND if the server lacks COUNT.
+
+class LeadCursor {
+private:
+    CRMSystem* crm;
+    std::string stage;
+    size_t page_size;
+    size_t max_pages;
+
+    StageSummary summary;           // whole stage
+    size_t visible = 0;             // rows under the filter, when paged
+    bool loaded = false;
+    bool paged = true;
+
+    std::unordered_map<size_t, std::vector<Lead>> pages;
+    std::vector<Lead> all;          // full snapshot, for servers without paging or search
+    std::vector<size_t> matches;    // indices into `all` matching the filter
+    std::string filter;
+
+    static bool contains(const std::string& hay, const std::string& needle) {
+        return hay.find(needle) != std::string::npos;
+    }
+
+    void load() {
+        if (loaded) return;
+        loaded = true;
+        pages.clear();
+        all.clear();
+        matches.clear();
+
+        // Windows come from the server when it can page (and search, if
+        // filtering); otherwise the stage is fetched once and filtered here
+        summary = crm->getStageSummary(stage);
+        paged = summary.ok && crm->supportsPaging() && (filter.empty() || crm->supportsSearch());
+        if (paged) {
+            visible = summary.count;
+            if (filter.empty()) return;
+            StageSummary found = crm->getStageSummary(stage, filter);
+            if (found.ok) {
+                visible = found.count;
+                return;
+            }
+            paged = false;
+        }
+
+        all = crm->getLeadsByStage(stage);
+        if (!summary.ok) {
+            summary.count = all.size();
+            summary.value = 0.0;
+            for (const auto& l : all) summary.value += l.value;
+        }
+        for (size_t i = 0; i < all.size(); i++) {
+            if (filter.empty() || contains(all[i].name, filter) || contains(all[i].company, filter))
+                matches.push_back(i);
+        }
+    }
+
+    void evict(size_t keep) {
+        while (pages.size() > max_pages) {
+            auto victim = pages.begin();
+            size_t worst = 0;
+            for (auto it = pages.begin(); it != pages.end(); ++it) {
+                size_t dist = it->first > keep ? it->first - keep : keep - it->first;
+                if (dist >= worst) { worst = dist; victim = it; }
+            }
+            pages.erase(victim);
+        }
+    }
+
+    const std::vector<Lead>& page(size_t index) {
+        auto it = pages.find(index);
+        if (it != pages.end()) return it->second;
+
+        auto& slot = pages[index];
+        slot = crm->getLeadsByStage(stage, index * page_size, page_size, filter);
+        evict(index);
+        return pages[index];
+    }
+
+public:
+    LeadCursor(CRMSystem& system, const std::string& stage_name, size_t page = 128, size_t cached_pages = 8)
+        : crm(&system), stage(stage_name), page_size(page), max_pages(cached_pages) {}
+
+    // Rows visible under the current filter
+    size_t size() {
+        load();
+        return paged ? visible : matches.size();
+    }
+
+    const StageSummary& stats() {
+        load();
+        return summary;
+    }
+
+    // Fetches the pages covering [first, last) ahead of the per-row at() calls
+    void prefetch(size_t first, size_t last) {
+        load();
+        if (!paged || first >= last) return;
+        for (size_t p = first / page_size; p <= (last - 1) / page_size; p++) page(p);
+    }
+
+    // nullptr if the row vanished since the count was taken.
+    // The pointer is only valid until the next call on this cursor.
+    const Lead* at(size_t row) {
+        load();
+        if (!paged) return row < matches.size() ? &all[matches[row]] : nullptr;
+
+        const auto& rows = page(row / page_size);
+        size_t offset = row % page_size;
+        return offset < rows.size() ? &rows[offset] : nullptr;
+    }
+
+    // Case-sensitive substring match on name/company, like the old search box
+    void setFilter(const std::string& text) {
+        if (text == filter) return;
+        filter = text;
+        invalidate();
+    }
+
+    // Per-frame variant for the search box; allocates only when the text changes
+    void setFilter(const char* text) {
+        if (filter.compare(text) == 0) return;
+        filter = text;
+        invalidate();
+    }
+
+    void invalidate() { loaded = false; }
+};
+
+// --- LEAD DETAILS CACHE ---
+
+// Tasks and notes of recently hovered leads, fetched on a background thread
+// so the details modal opens from memory. Keeps the newest `capacity` leads.
+// invalidate() marks every entry stale; stale entries are still served and
+// are refetched the next time they are asked for. A failed fetch stores
+// nothing, so a lead is never shown empty because the server was unreachable.
+class LeadDetailsCache {
+private:
+    struct Entry {
+        std::shared_ptr<const LeadDetails> details;
+        uint64_t generation = 0;
+        std::list<fluxdb::Id>::iterator recent;
+    };
+
+    CRMSystem* crm;
+    size_t capacity;
+
+    std::mutex lock;
+    std::condition_variable wake;
+    std::unordered_map<fluxdb::Id, Entry> entries;
+    std::list<fluxdb::Id> recent;              // most recently used first
+    std::deque<fluxdb::Id> wanted;             // newest request at the back
+    std::unordered_set<fluxdb::Id> queued;
+    uint64_t generation = 0;
+    uint64_t epoch = 0;                        // bumped by clear()
+    bool stopping = false;
+    std::function<void()> on_ready;
+
+    std::mutex fetching;                       // held while the worker talks to the server
+    std::thread worker;
+
+    bool fresh(fluxdb::Id id) const {
+        auto it = entries.find(id);
+        return it != entries.end() && it->second.generation == generation;
+    }
+
+    void queue(fluxdb::Id id) {
+        if (queued.count(id) || fresh(id)) return;
+        queued.insert(id);
+        wanted.push_back(id);
+        if (wanted.size() > capacity) {  // hovered long ago, unlikely to be opened
+            queued.erase(wanted.front());
+            wanted.pop_front();
+        }
+        wake.notify_one();
+    }
+
+    void store(fluxdb::Id id, std::shared_ptr<const LeadDetails> details, uint64_t gen) {
+        auto it = entries.find(id);
+        if (it != entries.end()) {
+            recent.erase(it->second.recent);
+        } else if (entries.size() >= capacity) {
+            entries.erase(recent.back());
+            recent.pop_back();
+        }
+        recent.push_front(id);
+        entries[id] = { std::move(details), gen, recent.begin() };
+    }
+
+    void fetchLoop() {
+        fluxdb::SpanRecorder::nameThread("details");
+        std::unique_lock<std::mutex> lk(lock);
+        while (true) {
+            wake.wait(lk, [this]() { return stopping || !wanted.empty(); });
+            if (stopping) return;
+
+            // Newest first: the card under the cursor now is the likely click
+            fluxdb::Id id = wanted.back();
+            wanted.pop_back();
+            uint64_t gen = generation, started_in = epoch;
+            std::unique_lock<std::mutex> busy(fetching);
+            lk.unlock();
+
+            auto details = std::make_shared<LeadDetails>();
+            bool ok;
+            {
+                FLUX_SPAN("details.fetch");
+                ok = crm->getDetails(id, *details);
+            }
+            busy.unlock();
+
+            lk.lock();
+            if (started_in != epoch) continue; // answered by the old connection
+            queued.erase(id);
+            if (!ok) continue; // keep what we had; the next get() asks again
+            store(id, std::move(details), gen);
+            if (on_ready) on_ready();
+        }
+    }
+
+public:
+    explicit LeadDetailsCache(CRMSystem& system, size_t max_leads = 64)
+        : crm(&system), capacity(std::max<size_t>(max_leads, 1)), worker(&LeadDetailsCache::fetchLoop, this) {}
+
+    ~LeadDetailsCache() {
+        {
+            std::lock_guard<std::mutex> lk(lock);
+            stopping = true;
+        }
+        wake.notify_all();
+        worker.join();
+    }
+
+    LeadDetailsCache(const LeadDetailsCache&) = delete;
+    LeadDetailsCache& operator=(const LeadDetailsCache&) = delete;
+
+    // Called on the worker thread after each fetch, e.g. to wake the UI
+    void setListener(std::function<void()> fn) {
+        std::lock_guard<std::mutex> lk(lock);
+        on_ready = std::move(fn);
+    }
+
+    // Starts a background fetch unless the lead is cached and fresh
+    void prefetch(fluxdb::Id id) {
+        std::lock_guard<std::mutex> lk(lock);
+        queue(id);
+    }
+
+    // Cached details (possibly stale), or nullptr until a first fetch succeeds.
+    // Queues a fetch when there is nothing fresh.
+    std::shared_ptr<const LeadDetails> get(fluxdb::Id id) {
+        std::lock_guard<std::mutex> lk(lock);
+        queue(id);
+        auto it = entries.find(id);
+        if (it == entries.end()) return nullptr;
+        recent.splice(recent.begin(), recent, it->second.recent);
+        return it->second.details;
+    }
+
+    // After our own edit of one lead's tasks or notes
+    void refresh(fluxdb::Id id) {
+        std::lock_guard<std::mutex> lk(lock);
+        auto it = entries.find(id);
+        if (it != entries.end()) it->second.generation = generation - 1;
+        queue(id);
+    }
+
+    // After a change event: anything may be out of date
+    void invalidate() {
+        std::lock_guard<std::mutex> lk(lock);
+        generation++;
+    }
+
+    // Drops everything and waits out a fetch in progress, e.g. before the
+    // CRMSystem reconnects underneath the worker
+    void clear() {
+        std::lock_guard<std::mutex> lk(lock);
+        std::lock_guard<std::mutex> busy(fetching);
+        entries.clear();
+        recent.clear();
+        wanted.clear();
+        queued.clear();
+        epoch++;
+    }
+};
+
 // --- EVENT TICKER ---
 
 class EventTicker {
 private:
-    std::deque<std::string> logs;
-    std::mutex lock;
+    CRM::EventRing ring;
+    std::atomic<uint64_t> cleared_at{0};    // events before this are hidden by clear()
     std::atomic<bool> running{false};
     std::thread worker;
+    std::function<void()> on_event;
+    IO::EventJournal* journal = nullptr;
+
+    // Subscription being listened on, so stop() can interrupt it
+    std::mutex client_lock;
+    fluxdb::FluxDBClient* active = nullptr;
 
     std::string ip;
     int port = 0;
     std::string password;
 
     void listenLoop() {
+        fluxdb::SpanRecorder::nameThread("ticker");
         try {
-            fluxdb::FluxDBClient subClient(ip, port);
+            // Pub/sub lives on the first node of a sharded cluster
+            auto nodes = fluxdb::parseNodeList(ip, port);
+            if (nodes.empty()) return;
+            fluxdb::FluxDBClient subClient(nodes[0].host, nodes[0].port);
 
             if (!password.empty()) {
                 subClient.auth(password);
             }
 
-            subClient.subscribe("crm_events", [this](const std::string& msg) {
+            {
+                std::lock_guard<std::mutex> lk(client_lock);
                 if (!running) return;
+                active = &subClient;
+            }
 
-                std::lock_guard<std::mutex> lk(lock);
-                logs.push_back(msg);
-                if (logs.size() > 50) logs.pop_front();
+            subClient.subscribe("crm_events", [this](const std::string& msg) {
+                if (!running) return;
+                FLUX_SPAN("ticker.event");
+                if (journal) journal->append(msg);
+                ring.push(msg);
+                if (on_event) on_event();
             });
-        } catch (...) {}
+
+            std::lock_guard<std::mutex> lk(client_lock);
+            active = nullptr;
+        } catch (...) {
+            std::lock_guard<std::mutex> lk(client_lock);
+            active = nullptr;
+        }
     }
 
 public:
+    // Keeps the newest `capacity` events (rounded up to a power of two)
+    explicit EventTicker(size_t capacity = 64) : ring(capacity) {}
+
     ~EventTicker() { stop(); }
 
+    // Called on the listener thread after each event. Set before start().
+    void setListener(std::function<void()> fn) { on_event = std::move(fn); }
+
+    // Records every event received into `j`, which must outlive the ticker. Set before start().
+    void setJournal(IO::EventJournal* j) { journal = j; }
+
+    // Refills the ring with the newest journaled events, e.g. from the last
+    // session. Returns the journal offset to resume from.
+    uint64_t loadHistory() {
+        if (!journal) return 0;
+        uint64_t end = journal->nextOffset();
+        uint64_t from = end > ring.capacity() ? end - ring.capacity() : 0;
+        return journal->replay(from, [&](uint64_t, std::string_view msg) { ring.push(msg.data(), msg.size()); });
+    }
+
     void start(const std::string& server_ip, int server_port, const std::string& pass) {
         if (running) return;
+        if (worker.joinable()) worker.join();
 
         running = true;
         ip = server_ip;
@@ -450,22 +1266,44 @@ public:
         worker = std::thread(&EventTicker::listenLoop, this);
     }
 
+    // Interrupts the subscription and waits for the listener to exit
     void stop() {
         running = false;
-        if (worker.joinable()) worker.detach();
+        {
+            std::lock_guard<std::mutex> lk(client_lock);
+            if (active) active->interrupt();
+        }
+        if (worker.joinable()) worker.join();
     }
 
-    std::vector<std::string> getLogs() {
-        std::lock_guard<std::mutex> lk(lock);
-        return {logs.begin(), logs.end()};
+    // Calls fn(uint64_t seq, std::string_view msg) for each event since `seq`,
+    // oldest first, without copying the log. Pass the returned next to the next call.
+    template <typename Fn>
+    CRM::EventRing::ReadResult eventsSince(uint64_t seq, Fn&& fn) const {
+        return ring.readSince(std::max(seq, cleared_at.load()), std::forward<Fn>(fn));
     }
 
-    void clear() {
-        std::lock_guard<std::mutex> lk(lock);
-        logs.clear();
+    std::vector<std::string> getLogs() const {
+        std::vector<std::string> out;
+        eventsSince(0, [&](uint64_t, std::string_view msg) { out.emplace_back(msg); });
+        return out;
     }
 
-    
+    // Calls fn(std::string_view) with the newest message, so callers can copy
+    // just what they draw. Returns false if there is none.
+    template <typename Fn>
+    bool withLatest(Fn&& fn) const {
+        return ring.latest(cleared_at.load(), [&](uint64_t, std::string_view msg) { fn(msg); });
+    }
+
+    void clear() { cleared_at = ring.head(); }
+
+    // Total events received; lets the UI notice changes without copying logs
+    uint64_t eventCount() const { return ring.head(); }
+
+    // Events that were overwritten before anyone read them, and events cut to EventRing::MAX_MESSAGE
+    uint64_t droppedCount() const { return ring.overwritten(); }
+    uint64_t truncatedCount() const { return ring.truncated(); }
 };
 
 #endif
@@ -0,0 +1,154 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+
+namespace CRM {
+
+    // Fixed-capacity ring of short text events, numbered by a sequence that only
+    // grows. Any number of threads may push; readers never block writers and
+    // never allocate. A full ring overwrites its oldest events, and readers that
+    // fall behind are told how many they missed.
+    //
+    // Each slot is a seqlock: a writer marks it odd while copying the text in
+    // and even once done, so a reader can tell a stable event from one that was
+    // overwritten under it.
+    class EventRing {
+    public:
+        static const size_t MAX_MESSAGE = 240; // longer events are truncated
+
+        struct ReadResult {
+            uint64_t next = 0;      // sequence to pass to the next readSince()
+            uint64_t missed = 0;    // events overwritten before they were read
+        };
+
+    private:
+        struct Slot {
+            std::atomic<uint64_t> state{0}; // 2*seq+1 while writing, 2*seq+2 once written
+            uint32_t len = 0;
+            char text[MAX_MESSAGE];
+        };
+
+        std::unique_ptr<Slot[]> slots;
+        size_t mask = 0;
+        std::atomic<uint64_t> next_seq{0};
+        std::atomic<uint64_t> truncated_count{0};
+
+        static size_t roundUp(size_t n) {
+            size_t p = 1;
+            while (p < n) p <<= 1;
+            return p;
+        }
+
+        // Copies event seq out of its slot. False if it is not written yet or was overwritten.
+        bool load(uint64_t seq, char* out, size_t& len) const {
+            const Slot& s = slots[seq & mask];
+            uint64_t want = 2 * seq + 2;
+            if (s.state.load(std::memory_order_acquire) != want) return false;
+            len = std::min<size_t>(s.len, MAX_MESSAGE);
+            memcpy(out, s.text, len);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            return s.state.load(std::memory_order_relaxed) == want;
+        }
+
+    public:
+        explicit EventRing(size_t capacity = 64) {
+            size_t n = roundUp(std::max<size_t>(capacity, 2));
+            slots.reset(new Slot[n]);
+            mask = n - 1;
+        }
+
+        EventRing(const EventRing&) = delete;
+        EventRing& operator=(const EventRing&) = delete;
+
+        size_t capacity() const { return mask + 1; }
+
+        // Returns the event's sequence number
+        uint64_t push(const char* msg, size_t len) {
+            uint64_t seq = next_seq.fetch_add(1, std::memory_order_relaxed);
+            Slot& s = slots[seq & mask];
+
+            // Wait for the previous lap's writer of this slot, only possible
+            // when producers are a whole ring apart
+            uint64_t prev = seq > mask ? 2 * (seq - capacity()) + 2 : 0;
+            while (true) {
+                uint64_t expected = prev;
+                if (s.state.compare_exchange_weak(expected, 2 * seq + 1, std::memory_order_relaxed)) break;
+                std::this_thread::yield();
+            }
+            std::atomic_thread_fence(std::memory_order_release);
+
+            if (len > MAX_MESSAGE) {
+                len = MAX_MESSAGE;
+                truncated_count.fetch_add(1, std::memory_order_relaxed);
+            }
+            memcpy(s.text, msg, len);
+            s.len = (uint32_t)len;
+            s.state.store(2 * seq + 2, std::memory_order_release);
+            return seq;
+        }
+
+        uint64_t push(const std::string& msg) { return push(msg.data(), msg.size()); }
+
+        // Sequence the next event will get; also the number of events ever pushed
+        uint64_t head() const { return next_seq.load(std::memory_order_acquire); }
+
+        // Events pushed but no longer held (overwritten by newer ones)
+        uint64_t overwritten() const {
+            uint64_t h = head();
+            return h > capacity() ? h - capacity() : 0;
+        }
+
+        uint64_t truncated() const { return truncated_count.load(std::memory_order_relaxed); }
+
+        // Calls fn(uint64_t seq, std::string_view text) for each event from `from`
+        // on, oldest first. The view is only valid during the call.
+        template <typename Fn>
+        ReadResult readSince(uint64_t from, Fn&& fn) const {
+            ReadResult r;
+            uint64_t end = head();
+            uint64_t oldest = end > capacity() ? end - capacity() : 0;
+            if (from < oldest) {
+                r.missed += oldest - from;
+                from = oldest;
+            }
+
+            char buf[MAX_MESSAGE];
+            for (uint64_t seq = from; seq < end; seq++) {
+                size_t len = 0;
+                if (load(seq, buf, len)) {
+                    fn(seq, std::string_view(buf, len));
+                    r.next = seq + 1;
+                } else if (slots[seq & mask].state.load(std::memory_order_acquire) > 2 * seq + 2) {
+                    r.missed++; // lapped while we read
+                    r.next = seq + 1;
+                } else {
+                    break; // claimed but still being written; pick it up next time
+                }
+            }
+            if (r.next < from) r.next = from;
+            return r;
+        }
+
+        // Newest fully written event, if any at or after `from`
+        template <typename Fn>
+        bool latest(uint64_t from, Fn&& fn) const {
+            char buf[MAX_MESSAGE];
+            for (uint64_t seq = head(); seq-- > from;) {
+                size_t len = 0;
+                if (load(seq, buf, len)) {
+                    fn(seq, std::string_view(buf, len));
+                    return true;
+                }
+                if (seq + capacity() < head()) return false;
+            }
+            return false;
+        }
+    };
+}
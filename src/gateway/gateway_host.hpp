@@ -0,0 +1,786 @@
+#pragma once
+#include "../../vendor/fluxdb/socket_compat.hpp"
+#include "../../vendor/fluxdb/sharded_client.hpp"
+#include "../../vendor/fluxdb/single_flight.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <iostream>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// Local multiplexing gateway (flux_crm --serve). Speaks the FluxDB text
+// protocol to any number of local clients (GUI, CLI, tools) and forwards to
+// a fixed pool of upstream connections per database:
+//
+//   * FIND / COUNT replies are shared: identical requests in flight are sent
+//     upstream once (SingleFlight) and replies are cached for a short TTL.
+//     Writes through the gateway and events from upstream drop the cache.
+//   * Writes a client pipelines (INSERT / UPDATE / DELETE / PUBLISH lines
+//     already received together) go upstream as one pipelined batch.
+//   * One upstream subscription per channel is fanned out to local clients.
+//     Each subscriber has its own outbox and sender thread, so a slow client
+//     delays only itself; one that falls MAX_OUTBOX_BYTES behind is dropped.
+//
+// Local clients asking for the binary protocol are answered in text.
+
+namespace Gateway {
+
+    struct GatewayConfig {
+        int port = 7070;                        // local listen port
+        std::string upstream = "127.0.0.1";     // node list, as for CONNECT
+        int upstream_port = 8080;               // default port for the list
+        std::string password = "flux_admin";    // upstream AUTH; local clients must send the same
+        size_t pool_size = 2;                   // upstream clients per database
+        int cache_ms = 1000;                    // max age of a cached FIND/COUNT reply
+        size_t cache_bytes = 64u << 20;
+        bool verbose = false;
+    };
+
+    struct GatewayStats {
+        std::atomic<uint64_t> clients{0};           // local connections accepted
+        std::atomic<uint64_t> commands{0};
+        std::atomic<uint64_t> upstream_reads{0};    // FIND/COUNT sent upstream
+        std::atomic<uint64_t> cache_hits{0};
+        std::atomic<uint64_t> upstream_batches{0};  // pipelined write batches
+        std::atomic<uint64_t> writes{0};
+        std::atomic<uint64_t> events{0};            // upstream messages fanned out
+        std::atomic<uint64_t> upstream_connections{0};
+    };
+
+    // FIND/COUNT replies by database and request line, bounded by bytes and age
+    class ReplyCache {
+    private:
+        struct Entry {
+            std::string reply;
+            std::chrono::steady_clock::time_point stored;
+            std::list<std::string>::iterator recent;
+        };
+
+        std::mutex lock;
+        std::unordered_map<std::string, Entry> entries;
+        std::list<std::string> recent;          // most recently used first
+        size_t bytes = 0;
+        size_t max_bytes;
+        std::chrono::milliseconds ttl;
+        uint64_t generation = 0;
+
+        void erase(std::unordered_map<std::string, Entry>::iterator it) {
+            bytes -= it->first.size() + it->second.reply.size();
+            recent.erase(it->second.recent);
+            entries.erase(it);
+        }
+
+    public:
+        ReplyCache(size_t limit, int ttl_ms) : max_bytes(limit), ttl(ttl_ms) {}
+
+        bool get(const std::string& key, std::string& out) {
+            std::lock_guard<std::mutex> lk(lock);
+            auto it = entries.find(key);
+            if (it == entries.end()) return false;
+            if (std::chrono::steady_clock::now() - it->second.stored > ttl) { erase(it); return false; }
+            recent.splice(recent.begin(), recent, it->second.recent);
+            out = it->second.reply;
+            return true;
+        }
+
+        // Taken before a read starts; put() ignores replies that predate a write
+        uint64_t ticket() {
+            std::lock_guard<std::mutex> lk(lock);
+            return generation;
+        }
+
+        void put(const std::string& key, const std::string& reply, uint64_t since) {
+            if (ttl.count() <= 0 || key.size() + reply.size() > max_bytes / 4) return;
+            std::lock_guard<std::mutex> lk(lock);
+            if (since != generation) return;
+            auto old = entries.find(key);
+            if (old != entries.end()) erase(old);
+            while (bytes + key.size() + reply.size() > max_bytes && !recent.empty()) erase(entries.find(recent.back()));
+            recent.push_front(key);
+            entries[key] = { reply, std::chrono::steady_clock::now(), recent.begin() };
+            bytes += key.size() + reply.size();
+        }
+
+        void invalidate() {
+            std::lock_guard<std::mutex> lk(lock);
+            entries.clear();
+            recent.clear();
+            bytes = 0;
+            generation++;
+        }
+    };
+
+    class GatewayHost {
+    private:
+        struct Session {
+            SOCKET sock = INVALID_SOCKET;
+            std::mutex write_lock;
+            std::string db = "default";
+            bool authed = false;
+
+            // MESSAGE lines waiting for the sender thread (started by SUBSCRIBE)
+            std::mutex out_lock;
+            std::condition_variable out_ready;
+            std::deque<std::string> outbox;
+            size_t out_bytes = 0;
+            bool closing = false;
+            std::thread sender;
+        };
+
+        static constexpr size_t MAX_OUTBOX_BYTES = 8u << 20;
+
+        struct Pool {
+            std::vector<std::shared_ptr<fluxdb::ShardedClient>> clients; // nullptr = reconnect on next use
+            size_t next = 0;
+        };
+
+        struct Channel {
+            std::vector<std::shared_ptr<Session>> subscribers;
+            fluxdb::FluxDBClient* active = nullptr;  // upstream subscription, for stop()
+            std::thread listener;
+        };
+
+        GatewayConfig config;
+        GatewayStats counters;
+        std::vector<fluxdb::NodeAddress> nodes;
+        SOCKET listener = INVALID_SOCKET;
+        std::atomic<bool> running{false};
+        std::thread acceptor;
+
+        std::mutex sessions_lock;
+        std::condition_variable sessions_done;
+        std::vector<std::shared_ptr<Session>> sessions;
+
+        std::mutex pools_lock;
+        std::unordered_map<std::string, Pool> pools;
+
+        std::mutex index_lock;
+        std::unordered_set<std::string> created_indexes; // "db\nfields" made through the gateway
+
+        std::mutex channels_lock;
+        std::unordered_map<std::string, Channel> channels;
+
+        ReplyCache cache;
+        fluxdb::SingleFlight<std::string> flights;
+
+        // --- UPSTREAM ---
+
+        std::shared_ptr<fluxdb::ShardedClient> connectUpstream(const std::string& db) {
+            auto client = std::make_shared<fluxdb::ShardedClient>(nodes);
+            // Reads are shared across the whole pool below; a per-client flight
+            // would not see writes that went through another pool member
+            client->setSingleFlight(false);
+            if (!client->auth(config.password)) throw std::runtime_error("UPSTREAM_AUTH_FAILED");
+            if (!client->use(db)) throw std::runtime_error("UPSTREAM_USE_FAILED");
+            return client;
+        }
+
+        // Round robin over the database's pool, (re)connecting lazily. The
+        // connect happens outside pools_lock, so a slow upstream only holds up
+        // the sessions that drew this slot.
+        std::shared_ptr<fluxdb::ShardedClient> pick(const std::string& db, size_t& slot) {
+            {
+                std::lock_guard<std::mutex> lk(pools_lock);
+                Pool& pool = pools[db];
+                if (pool.clients.empty()) pool.clients.resize(std::max<size_t>(config.pool_size, 1));
+                slot = pool.next++ % pool.clients.size();
+                if (pool.clients[slot]) return pool.clients[slot];
+            }
+
+            auto fresh = connectUpstream(db);
+            std::lock_guard<std::mutex> lk(pools_lock);
+            auto& held = pools[db].clients[slot];
+            if (held) return held; // another session connected it first
+            held = fresh;
+            counters.upstream_connections += nodes.size();
+            return held;
+        }
+
+        // After an upstream error the connection state is unknown; start over
+        void discard(const std::string& db, size_t slot, const std::shared_ptr<fluxdb::ShardedClient>& client) {
+            std::lock_guard<std::mutex> lk(pools_lock);
+            auto& held = pools[db].clients[slot];
+            if (held == client) {
+                held.reset();
+                counters.upstream_connections -= nodes.size();
+            }
+        }
+
+        template <typename Fn>
+        auto upstream(const std::string& db, Fn&& fn) -> decltype(fn(std::declval<fluxdb::ShardedClient&>())) {
+            size_t slot = 0;
+            auto client = pick(db, slot);
+            try {
+                return fn(*client);
+            } catch (...) {
+                discard(db, slot, client);
+                throw;
+            }
+        }
+
+        void dataChanged() {
+            cache.invalidate();
+            flights.invalidate();
+        }
+
+        // --- EVENTS ---
+
+        void fanOut(const std::string& channel, const std::string& message) {
+            dataChanged(); // whoever published just wrote something
+            counters.events++;
+            std::vector<std::shared_ptr<Session>> receivers;
+            {
+                std::lock_guard<std::mutex> lk(channels_lock);
+                auto it = channels.find(channel);
+                if (it != channels.end()) receivers = it->second.subscribers;
+            }
+            std::string line = "MESSAGE " + channel + " " + message + "\n";
+            for (auto& r : receivers) post(*r, line);
+        }
+
+        // Queues a line for the session's sender; never blocks on the socket
+        void post(Session& s, const std::string& line) {
+            {
+                std::lock_guard<std::mutex> lk(s.out_lock);
+                if (s.closing) return;
+                if (s.out_bytes + line.size() > MAX_OUTBOX_BYTES) {
+                    // Too far behind: hang up, serve() then cleans up
+                    s.closing = true;
+                    s.outbox.clear();
+                    s.out_bytes = 0;
+                    if (s.sock != INVALID_SOCKET) shutdown(s.sock, FLUX_SHUT_RDWR);
+                } else {
+                    s.outbox.push_back(line);
+                    s.out_bytes += line.size();
+                }
+            }
+            s.out_ready.notify_one();
+        }
+
+        // Sends everything queued so far in one write, until the session closes
+        void sendLoop(std::shared_ptr<Session> s) {
+            std::string batch;
+            while (true) {
+                {
+                    std::unique_lock<std::mutex> lk(s->out_lock);
+                    s->out_ready.wait(lk, [&]() { return s->closing || !s->outbox.empty(); });
+                    if (s->closing) return;
+                    batch.clear();
+                    for (auto& line : s->outbox) batch += line;
+                    s->outbox.clear();
+                    s->out_bytes = 0;
+                }
+                if (!write(*s, batch)) return;
+            }
+        }
+
+        void relay(const std::string& channel) {
+            while (running) {
+                try {
+                    fluxdb::FluxDBClient client(nodes[0].host, nodes[0].port);
+                    if (!config.password.empty()) client.auth(config.password);
+                    {
+                        std::lock_guard<std::mutex> lk(channels_lock);
+                        if (!running) return;
+                        channels[channel].active = &client;
+                    }
+                    counters.upstream_connections++;
+                    client.subscribe(channel, [this, &channel](const std::string& msg) { fanOut(channel, msg); });
+                    counters.upstream_connections--;
+                } catch (...) {}
+
+                {
+                    std::lock_guard<std::mutex> lk(channels_lock);
+                    channels[channel].active = nullptr;
+                }
+                if (!running) return;
+                // Messages may have been missed while reconnecting
+                dataChanged();
+                std::this_thread::sleep_for(std::chrono::milliseconds(500));
+            }
+        }
+
+        void subscribe(const std::shared_ptr<Session>& s, const std::string& channel) {
+            if (!s->sender.joinable()) s->sender = std::thread(&GatewayHost::sendLoop, this, s);
+            std::lock_guard<std::mutex> lk(channels_lock);
+            Channel& c = channels[channel];
+            if (std::find(c.subscribers.begin(), c.subscribers.end(), s) == c.subscribers.end()) c.subscribers.push_back(s);
+            if (!c.listener.joinable()) c.listener = std::thread(&GatewayHost::relay, this, channel);
+        }
+
+        // --- COMMANDS ---
+
+        // Splits "<json> tail" at the end of the leading JSON object
+        static bool splitJson(const std::string& text, std::string& json, std::string& tail) {
+            size_t start = text.find('{');
+            if (start == std::string::npos) return false;
+
+            int depth = 0;
+            bool in_string = false;
+            for (size_t i = start; i < text.size(); i++) {
+                char c = text[i];
+                if (in_string) {
+                    if (c == '\\') i++;
+                    else if (c == '"') in_string = false;
+                    continue;
+                }
+                if (c == '"') in_string = true;
+                else if (c == '{') depth++;
+                else if (c == '}' && --depth == 0) {
+                    json = text.substr(start, i - start + 1);
+                    tail = text.substr(i + 1);
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        static bool isWrite(const std::string& cmd) {
+            return cmd == "INSERT" || cmd == "UPDATE" || cmd == "DELETE" || cmd == "PUBLISH";
+        }
+
+        // One of the lines above as a BatchOp; false on a syntax error
+        static bool parseWrite(const std::string& cmd, const std::string& args, fluxdb::BatchOp& op) {
+            size_t space = args.find(' ');
+            if (cmd == "INSERT") {
+                op.kind = fluxdb::BatchOp::Kind::Insert;
+                op.doc = fluxdb::QueryParser(args).parseJSON();
+            } else if (cmd == "UPDATE") {
+                if (space == std::string::npos) return false;
+                op.kind = fluxdb::BatchOp::Kind::Update;
+                op.id = std::stoull(args.substr(0, space));
+                op.doc = fluxdb::QueryParser(args.substr(space + 1)).parseJSON();
+            } else if (cmd == "DELETE") {
+                op.kind = fluxdb::BatchOp::Kind::Remove;
+                op.id = std::stoull(args);
+            } else {
+                if (space == std::string::npos) return false;
+                op.kind = fluxdb::BatchOp::Kind::Publish;
+                op.channel = args.substr(0, space);
+                op.message = args.substr(space + 1);
+            }
+            return true;
+        }
+
+        static std::string writeReply(const fluxdb::BatchOp& op, const fluxdb::BatchResult& r) {
+            switch (op.kind) {
+                case fluxdb::BatchOp::Kind::Insert: return r.ok ? "OK ID=" + std::to_string(r.id) + "\n" : "ERR INSERT_FAILED\n";
+                case fluxdb::BatchOp::Kind::Update: return r.ok ? "OK UPDATED\n" : "ERR NOT_FOUND\n";
+                case fluxdb::BatchOp::Kind::Remove: return r.ok ? "OK DELETED\n" : "ERR NOT_FOUND\n";
+                case fluxdb::BatchOp::Kind::Publish: return r.ok ? "OK RECEIVERS=" + std::to_string(r.receivers) + "\n" : "ERR PUBLISH_FAILED\n";
+            }
+            return "ERR\n";
+        }
+
+        // Consecutive write lines as one upstream pipeline; replies in order
+        std::string runWrites(Session& s, const std::vector<std::string>& lines) {
+            std::vector<std::string> replies(lines.size());
+            std::vector<fluxdb::BatchOp> ops;
+            std::vector<size_t> owner; // ops[k] answers lines[owner[k]]
+            for (size_t i = 0; i < lines.size(); i++) {
+                size_t space = lines[i].find(' ');
+                fluxdb::BatchOp op;
+                try {
+                    if (space == std::string::npos || !parseWrite(lines[i].substr(0, space), lines[i].substr(space + 1), op)) {
+                        replies[i] = "ERR SYNTAX\n";
+                        continue;
+                    }
+                } catch (const std::exception& e) {
+                    replies[i] = std::string("ERR ") + e.what() + "\n";
+                    continue;
+                }
+                ops.push_back(std::move(op));
+                owner.push_back(i);
+            }
+
+            if (!ops.empty()) {
+                // PUBLISH is not tied to a database: reuse any open pool
+                bool publish_only = std::all_of(ops.begin(), ops.end(), [](const fluxdb::BatchOp& op) {
+                    return op.kind == fluxdb::BatchOp::Kind::Publish;
+                });
+                std::string db = s.db;
+                if (publish_only) {
+                    std::lock_guard<std::mutex> lk(pools_lock);
+                    if (!pools.empty() && !pools.count(db)) db = pools.begin()->first;
+                }
+
+                // Not connected: nothing was sent. Failed mid-batch: any write
+                // may have been applied, so the client is told it cannot know.
+                std::vector<fluxdb::BatchResult> results;
+                const char* failure = nullptr;
+                size_t slot = 0;
+                std::shared_ptr<fluxdb::ShardedClient> client;
+                try {
+                    client = pick(db, slot);
+                } catch (...) {
+                    failure = "ERR UPSTREAM_UNAVAILABLE\n";
+                }
+                if (client) {
+                    try {
+                        results = client->pipeline(ops);
+                    } catch (...) {
+                        failure = "ERR UNKNOWN_OUTCOME\n";
+                    }
+                    bool lost = failure || std::any_of(results.begin(), results.end(), [](const fluxdb::BatchResult& r) { return !r.answered; });
+                    if (lost) discard(db, slot, client);
+                    dataChanged();
+                    counters.upstream_batches++;
+                    counters.writes += ops.size();
+                }
+                for (size_t k = 0; k < ops.size(); k++) {
+                    fluxdb::BatchResult r = k < results.size() ? results[k] : fluxdb::BatchResult{};
+                    if (failure) replies[owner[k]] = failure;
+                    else if (!r.answered) replies[owner[k]] = "ERR UNKNOWN_OUTCOME\n";
+                    else replies[owner[k]] = writeReply(ops[k], r);
+                }
+            }
+
+            std::string out;
+            for (auto& r : replies) out += r;
+            return out;
+        }
+
+        // Cached, then shared with identical requests in flight, then upstream
+        template <typename Fetch>
+        std::string sharedRead(Session& s, const std::string& line, Fetch fetch) {
+            std::string key = s.db + '\n' + line, reply;
+            if (cache.get(key, reply)) {
+                counters.cache_hits++;
+                return reply;
+            }
+            return flights.run(key, [&]() {
+                uint64_t ticket = cache.ticket(); // before the request: a write after it voids the reply
+                counters.upstream_reads++;
+                std::string fresh = upstream(s.db, fetch);
+                cache.put(key, fresh, ticket);
+                return fresh;
+            });
+        }
+
+        // FIND <json> [SKIP n] [LIMIT n], answered like fluxd
+        std::string cmdFind(Session& s, const std::string& line, const std::string& args) {
+            std::string json, tail;
+            if (!splitJson(args, json, tail)) return "ERR SYNTAX\n";
+            fluxdb::Document query = fluxdb::QueryParser(json).parseJSON();
+
+            size_t skip = 0, limit = 0;
+            bool paged = false;
+            std::stringstream opts(tail);
+            std::string word;
+            while (opts >> word) {
+                if (word == "SKIP") { opts >> skip; paged = true; }
+                else if (word == "LIMIT") { opts >> limit; paged = true; }
+            }
+
+            return sharedRead(s, line, [&](fluxdb::ShardedClient& c) {
+                std::vector<fluxdb::Document> docs = paged ? c.find(query, skip, limit) : c.find(query);
+                std::string reply = "OK COUNT=" + std::to_string(docs.size()) + "\n";
+                for (auto& doc : docs) {
+                    auto id = doc.find("_id");
+                    if (id == doc.end()) continue;
+                    reply += "ID " + std::to_string(id->second->asInt()) + " ";
+                    doc.erase(id);
+                    reply += fluxdb::Value(doc).ToJson();
+                    reply += '\n';
+                }
+                return reply;
+            });
+        }
+
+        // COUNT <json> [SUM field]
+        std::string cmdCount(Session& s, const std::string& line, const std::string& args) {
+            std::string json, tail;
+            if (!splitJson(args, json, tail)) return "ERR SYNTAX\n";
+            fluxdb::Document query = fluxdb::QueryParser(json).parseJSON();
+
+            std::string sumField;
+            std::stringstream opts(tail);
+            std::string word;
+            while (opts >> word) {
+                if (word == "SUM") opts >> sumField;
+            }
+
+            return sharedRead(s, line, [&](fluxdb::ShardedClient& c) {
+                fluxdb::CountResult r = c.count(query, sumField);
+                if (!r.ok) return std::string("ERR COUNT_FAILED\n");
+                std::string reply = "OK COUNT=" + std::to_string(r.count);
+                if (!sumField.empty()) reply += " SUM=" + fluxdb::Value(r.sum).ToJson();
+                return reply + "\n";
+            });
+        }
+
+        // INDEX CREATE|DROP <fields> | INDEX LIST
+        std::string cmdIndex(Session& s, const std::string& args) {
+            std::stringstream in(args);
+            std::string verb, spec;
+            in >> verb >> spec;
+            std::vector<std::string> fields;
+            std::stringstream list(spec);
+            std::string field;
+            while (std::getline(list, field, ',')) fields.push_back(field);
+
+            if (verb == "LIST") {
+                auto indexes = upstream(s.db, [](fluxdb::ShardedClient& c) { return c.listIndexes(); });
+                std::string reply = "OK COUNT=" + std::to_string(indexes.size()) + "\n";
+                for (const auto& f : indexes) {
+                    reply += "INDEX ";
+                    for (size_t i = 0; i < f.size(); i++) reply += (i ? "," : "") + f[i];
+                    reply += "\n";
+                }
+                return reply;
+            }
+            // Every client creates the schema indexes on connect; only the first
+            // goes upstream (or the first few, racing: CREATE is idempotent)
+            std::string key = s.db + '\n' + spec;
+            if (verb == "CREATE") {
+                {
+                    std::lock_guard<std::mutex> lk(index_lock);
+                    if (created_indexes.count(key)) return "OK INDEX_EXISTS\n";
+                }
+                if (!upstream(s.db, [&](fluxdb::ShardedClient& c) { return c.createIndex(fields); })) return "ERR INDEX_FAILED\n";
+                std::lock_guard<std::mutex> lk(index_lock);
+                created_indexes.insert(key);
+                return "OK INDEX_CREATED\n";
+            }
+            if (verb == "DROP") {
+                {
+                    std::lock_guard<std::mutex> lk(index_lock);
+                    created_indexes.erase(key);
+                }
+                return upstream(s.db, [&](fluxdb::ShardedClient& c) { return c.dropIndex(fields); }) ? "OK INDEX_DROPPED\n" : "ERR NOT_FOUND\n";
+            }
+            return "ERR SYNTAX\n";
+        }
+
+        std::string statsLine() {
+            const GatewayStats& st = counters;
+            std::string sessions_now;
+            {
+                std::lock_guard<std::mutex> lk(sessions_lock);
+                sessions_now = std::to_string(sessions.size());
+            }
+            return "OK CLIENTS=" + sessions_now + " UPSTREAM=" + std::to_string(st.upstream_connections.load()) +
+                   " COMMANDS=" + std::to_string(st.commands.load()) + " READS=" + std::to_string(st.upstream_reads.load()) +
+                   " CACHE_HITS=" + std::to_string(st.cache_hits.load()) + " SHARED=" + std::to_string(flights.stats().hits) +
+                   " WRITES=" + std::to_string(st.writes.load()) + " BATCHES=" + std::to_string(st.upstream_batches.load()) +
+                   " EVENTS=" + std::to_string(st.events.load()) + "\n";
+        }
+
+        std::string dispatch(const std::shared_ptr<Session>& s, const std::string& line) {
+            size_t space = line.find(' ');
+            std::string cmd = line.substr(0, space);
+            std::string args = (space == std::string::npos) ? "" : line.substr(space + 1);
+
+            if (cmd == "AUTH") {
+                s->authed = config.password.empty() || args == config.password;
+                return s->authed ? "OK AUTHENTICATED\n" : "ERR AUTH_FAILED\n";
+            }
+            if (!s->authed && !config.password.empty()) return "ERR NOT_AUTHENTICATED\n";
+
+            try {
+                if (cmd == "USE")       { s->db = args; return "OK SWITCHED_TO " + args + "\n"; }
+                if (cmd == "FIND")      return cmdFind(*s, line, args);
+                if (cmd == "COUNT")     return cmdCount(*s, line, args);
+                if (cmd == "INDEX")     return cmdIndex(*s, args);
+                if (cmd == "SUBSCRIBE") { subscribe(s, args); return "OK SUBSCRIBED " + args + "\n"; }
+                if (cmd == "GATEWAY")   return statsLine();
+            } catch (const std::exception& e) {
+                return std::string("ERR ") + e.what() + "\n";
+            }
+            return "ERR UNKNOWN_COMMAND\n"; // includes HELLO: the client stays on text
+        }
+
+        // --- LOCAL CONNECTIONS ---
+
+        bool write(Session& s, const std::string& data) {
+            std::lock_guard<std::mutex> lk(s.write_lock);
+            if (s.sock == INVALID_SOCKET) return false;
+            size_t sent = 0;
+            while (sent < data.size()) {
+                int n = send(s.sock, data.data() + sent, (int)(data.size() - sent), FLUX_SEND_FLAGS);
+                if (n <= 0) return false;
+                sent += n;
+            }
+            return true;
+        }
+
+        void serve(std::shared_ptr<Session> s) {
+            std::string inbox;
+            char buffer[4096];
+            std::vector<std::string> lines, writes;
+
+            while (running) {
+                int bytes = recv(s->sock, buffer, sizeof(buffer), 0);
+                if (bytes <= 0) break;
+                inbox.append(buffer, bytes);
+
+                lines.clear();
+                size_t start = 0, nl;
+                while ((nl = inbox.find('\n', start)) != std::string::npos) {
+                    std::string line = inbox.substr(start, nl - start);
+                    start = nl + 1;
+                    if (!line.empty() && line.back() == '\r') line.pop_back();
+                    if (!line.empty()) lines.push_back(std::move(line));
+                }
+                inbox.erase(0, start);
+
+                // Everything that arrived together is answered with one send
+                std::string out;
+                for (size_t i = 0; i < lines.size(); i++) {
+                    counters.commands++;
+                    if (config.verbose) std::cout << "[gateway] " << lines[i].substr(0, 120) << "\n";
+                    std::string cmd = lines[i].substr(0, lines[i].find(' '));
+                    if (!isWrite(cmd) || !s->authed) {
+                        out += dispatch(s, lines[i]);
+                        continue;
+                    }
+                    writes.clear();
+                    while (i < lines.size() && isWrite(lines[i].substr(0, lines[i].find(' ')))) {
+                        writes.push_back(lines[i]);
+                        if (writes.size() > 1) counters.commands++;
+                        i++;
+                    }
+                    i--;
+                    out += runWrites(*s, writes);
+                }
+                if (!out.empty() && !write(*s, out)) break;
+            }
+
+            {
+                std::lock_guard<std::mutex> lk(channels_lock);
+                for (auto& [name, c] : channels)
+                    c.subscribers.erase(std::remove(c.subscribers.begin(), c.subscribers.end(), s), c.subscribers.end());
+            }
+
+            // Stop the sender first; shutting the socket down fails a send it is blocked in
+            {
+                std::lock_guard<std::mutex> ol(s->out_lock);
+                s->closing = true;
+                shutdown(s->sock, FLUX_SHUT_RDWR);
+            }
+            s->out_ready.notify_one();
+            if (s->sender.joinable()) s->sender.join();
+
+            std::lock_guard<std::mutex> lk(sessions_lock);
+            {
+                std::lock_guard<std::mutex> wl(s->write_lock);
+                closesocket(s->sock);
+                s->sock = INVALID_SOCKET;
+            }
+            sessions.erase(std::remove(sessions.begin(), sessions.end(), s), sessions.end());
+            sessions_done.notify_all();
+        }
+
+        void acceptLoop() {
+            while (running) {
+                fd_set readable;
+                FD_ZERO(&readable);
+                FD_SET(listener, &readable);
+                timeval tv{0, 100000}; // poll running every 100ms
+                if (select((int)listener + 1, &readable, nullptr, nullptr, &tv) <= 0) continue;
+
+                SOCKET client = accept(listener, nullptr, nullptr);
+                if (client == INVALID_SOCKET) continue;
+
+                int one = 1;
+                setsockopt(client, IPPROTO_TCP, TCP_NODELAY, (const char*)&one, sizeof(one));
+
+                auto s = std::make_shared<Session>();
+                s->sock = client;
+                counters.clients++;
+
+                std::lock_guard<std::mutex> lk(sessions_lock);
+                sessions.push_back(s);
+                std::thread(&GatewayHost::serve, this, s).detach();
+            }
+        }
+
+    public:
+        explicit GatewayHost(GatewayConfig cfg)
+            : config(std::move(cfg)), cache(config.cache_bytes, config.cache_ms) {}
+
+        GatewayHost(const GatewayHost&) = delete;
+        GatewayHost& operator=(const GatewayHost&) = delete;
+
+        ~GatewayHost() { stop(); }
+
+        // Listens on localhost only: the gateway authenticates upstream for its clients
+        bool start() {
+            nodes = fluxdb::parseNodeList(config.upstream, config.upstream_port);
+            if (nodes.empty()) return false;
+
+            WSADATA wsaData;
+            WSAStartup(MAKEWORD(2, 2), &wsaData);
+
+            listener = socket(AF_INET, SOCK_STREAM, 0);
+            if (listener == INVALID_SOCKET) return false;
+
+            int one = 1;
+            setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, (const char*)&one, sizeof(one));
+
+            sockaddr_in addr{};
+            addr.sin_family = AF_INET;
+            addr.sin_port = htons((unsigned short)config.port);
+            addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+            if (bind(listener, (sockaddr*)&addr, sizeof(addr)) == SOCKET_ERROR || listen(listener, 64) == SOCKET_ERROR) {
+                closesocket(listener);
+                listener = INVALID_SOCKET;
+                return false;
+            }
+
+            socklen_t len = sizeof(addr);
+            getsockname(listener, (sockaddr*)&addr, &len);
+            config.port = ntohs(addr.sin_port);
+
+            running = true;
+            acceptor = std::thread(&GatewayHost::acceptLoop, this);
+            return true;
+        }
+
+        void stop() {
+            if (!running.exchange(false)) return;
+            if (acceptor.joinable()) acceptor.join();
+            closesocket(listener);
+            listener = INVALID_SOCKET;
+
+            {
+                std::unique_lock<std::mutex> lk(sessions_lock);
+                for (auto& s : sessions) {
+                    std::lock_guard<std::mutex> wl(s->write_lock);
+                    if (s->sock != INVALID_SOCKET) shutdown(s->sock, FLUX_SHUT_RDWR); // unblocks recv()
+                }
+                sessions_done.wait(lk, [this]() { return sessions.empty(); });
+            }
+
+            std::vector<std::thread> listeners;
+            {
+                std::lock_guard<std::mutex> lk(channels_lock);
+                for (auto& [name, c] : channels) {
+                    if (c.active) c.active->interrupt();
+                    if (c.listener.joinable()) listeners.push_back(std::move(c.listener));
+                }
+            }
+            for (auto& t : listeners) t.join();
+
+            std::lock_guard<std::mutex> lk(pools_lock);
+            pools.clear();
+            WSACleanup();
+        }
+
+        int port() const { return config.port; }
+        const GatewayStats& stats() const { return counters; }
+        std::string statsText() { return statsLine(); }
+    };
+}
@@ -5,6 +5,7 @@
 #include "imgui.h"
 #include "backends/imgui_impl_win32.h"
 #include "backends/imgui_impl_dx11.h"
+#include "ui/frame_pacer.hpp"
 
 extern IMGUI_IMPL_API LRESULT ImGui_ImplWin32_WndProcHandler(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam);
 
@@ -45,6 +46,7 @@ inline LRESULT WINAPI WndProc(HWND hWnd, UINT msg, WPARAM wParam, LPARAM lParam)
 class AppHost {
     HWND hwnd;
     WNDCLASSEXW wc;
+    UI::FramePacer pacer;
 
 public:
     AppHost(const wchar_t* title, int width, int height) {
@@ -87,6 +89,10 @@ public:
 
         ShowWindow(hwnd, SW_SHOWDEFAULT);
         UpdateWindow(hwnd);
+
+        // WM_NULL just breaks MsgWaitForMultipleObjects out of its sleep
+        HWND target = hwnd;
+        pacer.SetWaker([target]() { ::PostMessageW(target, WM_NULL, 0, 0); });
     }
 
     ~AppHost() {
@@ -101,12 +107,27 @@ public:
         UnregisterClassW(wc.lpszClassName, wc.hInstance);
     }
 
+    UI::FramePacer& Pacer() { return pacer; }
+
+    // Blocks until there is something to draw (input, Notify(), timer) unless idle mode is off
     bool NewFrame() {
-        MSG msg;
-        while (::PeekMessage(&msg, nullptr, 0U, 0U, PM_REMOVE)) {
-            ::TranslateMessage(&msg);
-            ::DispatchMessage(&msg);
-            if (msg.message == WM_QUIT) return false;
+        while (true) {
+            MSG msg;
+            bool had_input = false;
+            while (::PeekMessage(&msg, nullptr, 0U, 0U, PM_REMOVE)) {
+                ::TranslateMessage(&msg);
+                ::DispatchMessage(&msg);
+                if (msg.message == WM_QUIT) return false;
+                if (msg.message != WM_NULL) had_input = true;
+            }
+            if (had_input) pacer.MarkDirty();
+
+            double now = UI::FramePacer::Now();
+            if (pacer.ShouldRender(now)) break;
+
+            double wait = pacer.SecondsUntilNextFrame(now);
+            DWORD ms = (wait < 0) ? INFINITE : (DWORD)(wait * 1000.0) + 1;
+            ::MsgWaitForMultipleObjects(0, nullptr, FALSE, ms, QS_ALLINPUT);
         }
         ImGui_ImplDX11_NewFrame();
         ImGui_ImplWin32_NewFrame();
@@ -121,6 +142,7 @@ public:
         g_pd3dDeviceContext->ClearRenderTargetView(g_mainRenderTargetView, clear_color);
         ImGui_ImplDX11_RenderDrawData(ImGui::GetDrawData());
         g_pSwapChain->Present(1, 0);
+        pacer.FrameRendered(UI::FramePacer::Now(), UI::FrameSignals::Capture());
     }
 };
 
@@ -0,0 +1,370 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Local append-only journal of the events the ticker receives, so a restarted
+// GUI can show what happened before it closed.
+//
+// Events are numbered by offset (0, 1, 2, ... across the whole journal) and
+// stored in segment files named after their first offset:
+//   <dir>/events-00000000000000000000.log
+//
+// Segment: "FLXJRNL1", then records
+//   u32 length | u32 crc32(offset, payload) | u64 offset | payload
+// all little-endian. A record that fails its checksum ends the segment: it
+// is the tail of a write cut short by a crash, and open() truncates it away.
+
+namespace IO {
+
+    inline uint32_t crc32(const char* p, size_t n, uint32_t crc = 0) {
+        static const auto table = [] {
+            std::vector<uint32_t> t(256);
+            for (uint32_t i = 0; i < 256; i++) {
+                uint32_t c = i;
+                for (int k = 0; k < 8; k++) c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+                t[i] = c;
+            }
+            return t;
+        }();
+
+        crc = ~crc;
+        for (size_t i = 0; i < n; i++) crc = table[(crc ^ (uint8_t)p[i]) & 0xff] ^ (crc >> 8);
+        return ~crc;
+    }
+
+    // --- MAPPED FILE ---
+    // Read-only view of a whole file
+
+    class MappedFile {
+    private:
+        const char* base = nullptr;
+        size_t length = 0;
+#ifdef _WIN32
+        HANDLE file = INVALID_HANDLE_VALUE;
+        HANDLE mapping = nullptr;
+#endif
+
+    public:
+        MappedFile() = default;
+        ~MappedFile() { close(); }
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        bool open(const std::filesystem::path& path) {
+            close();
+#ifdef _WIN32
+            file = CreateFileW(path.wstring().c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                               nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+            if (file == INVALID_HANDLE_VALUE) return false;
+            LARGE_INTEGER size;
+            if (!GetFileSizeEx(file, &size)) { close(); return false; }
+            length = (size_t)size.QuadPart;
+            if (length == 0) return true; // empty files cannot be mapped
+            mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (!mapping) { close(); return false; }
+            base = (const char*)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+#else
+            int fd = ::open(path.c_str(), O_RDONLY);
+            if (fd < 0) return false;
+            struct stat st;
+            if (fstat(fd, &st) != 0) { ::close(fd); return false; }
+            length = (size_t)st.st_size;
+            if (length == 0) { ::close(fd); return true; }
+            void* p = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+            ::close(fd); // the mapping keeps the file alive
+            base = p == MAP_FAILED ? nullptr : (const char*)p;
+#endif
+            if (!base) { close(); return false; }
+            return true;
+        }
+
+        void close() {
+#ifdef _WIN32
+            if (base) UnmapViewOfFile(base);
+            if (mapping) CloseHandle(mapping);
+            if (file != INVALID_HANDLE_VALUE) CloseHandle(file);
+            mapping = nullptr;
+            file = INVALID_HANDLE_VALUE;
+#else
+            if (base) munmap((void*)base, length);
+#endif
+            base = nullptr;
+            length = 0;
+        }
+
+        const char* data() const { return base; }
+        size_t size() const { return length; }
+    };
+
+    // --- EVENT JOURNAL ---
+
+    struct JournalOptions {
+        size_t segment_bytes = 4 << 20;  // start a new segment past this size
+        size_t max_segments = 16;        // oldest segments are dropped beyond this
+    };
+
+    class EventJournal {
+    public:
+        static constexpr const char* MAGIC = "FLXJRNL1";
+        static const size_t HEADER = 8;
+        static const size_t RECORD_HEADER = 16;
+        static const uint32_t MAX_RECORD = 1 << 20;
+
+    private:
+        struct Segment {
+            uint64_t first = 0;
+            std::filesystem::path path;
+        };
+
+        std::filesystem::path dir;
+        JournalOptions opts;
+        std::vector<Segment> segments;  // oldest first; the last one is appended to
+        FILE* active = nullptr;
+        size_t active_bytes = 0;
+        uint64_t next = 0;
+        mutable std::mutex lock;
+
+        static void put32(char* p, uint32_t v) { for (int i = 0; i < 4; i++) p[i] = (char)(v >> (8 * i)); }
+        static void put64(char* p, uint64_t v) { for (int i = 0; i < 8; i++) p[i] = (char)(v >> (8 * i)); }
+        static uint32_t get32(const char* p) { uint32_t v = 0; for (int i = 0; i < 4; i++) v |= (uint32_t)(uint8_t)p[i] << (8 * i); return v; }
+        static uint64_t get64(const char* p) { uint64_t v = 0; for (int i = 0; i < 8; i++) v |= (uint64_t)(uint8_t)p[i] << (8 * i); return v; }
+
+        static std::string segmentName(uint64_t first) {
+            char buf[48];
+            snprintf(buf, sizeof(buf), "events-%020llu.log", (unsigned long long)first);
+            return buf;
+        }
+
+        static bool parseName(const std::string& name, uint64_t& first) {
+            if (name.size() != 31 || name.compare(0, 7, "events-") != 0 || name.compare(27, 4, ".log") != 0) return false;
+            first = 0;
+            for (size_t i = 7; i < 27; i++) {
+                if (name[i] < '0' || name[i] > '9') return false;
+                first = first * 10 + (uint64_t)(name[i] - '0');
+            }
+            return true;
+        }
+
+        // Calls fn(offset, payload) for each intact record of a segment and
+        // returns the length of the intact prefix
+        template <typename Fn>
+        static size_t walk(const char* data, size_t size, uint64_t first, Fn&& fn) {
+            if (size < HEADER || memcmp(data, MAGIC, HEADER) != 0) return 0;
+            size_t pos = HEADER;
+            uint64_t expect = first;
+            while (size - pos >= RECORD_HEADER) {
+                const char* rec = data + pos;
+                uint32_t len = get32(rec);
+                uint32_t crc = get32(rec + 4);
+                uint64_t offset = get64(rec + 8);
+                if (len > MAX_RECORD || size - pos - RECORD_HEADER < len) break;
+                if (offset != expect || crc32(rec + RECORD_HEADER, len, crc32(rec + 8, 8)) != crc) break;
+                fn(offset, std::string_view(rec + RECORD_HEADER, len));
+                pos += RECORD_HEADER + len;
+                expect++;
+            }
+            return pos;
+        }
+
+        bool startSegment(uint64_t first) {
+            if (active) fclose(active);
+            Segment seg{ first, dir / segmentName(first) };
+            active = fopen(seg.path.string().c_str(), "wb");
+            if (!active) return false;
+            active_bytes = HEADER;
+            if (fwrite(MAGIC, 1, HEADER, active) != HEADER || fflush(active) != 0) {
+                fclose(active);
+                active = nullptr;
+                return false;
+            }
+            segments.push_back(std::move(seg));
+            return true;
+        }
+
+        // Cuts a partly written record off the active segment, so the next
+        // append does not land behind it (open() would drop everything after
+        // a torn record). If that fails the journal stops taking appends.
+        void discardTail() {
+            fclose(active); // may flush more of the record; it is cut below
+            active = nullptr;
+            std::error_code ec;
+            std::filesystem::resize_file(segments.back().path, active_bytes, ec);
+            if (!ec) active = fopen(segments.back().path.string().c_str(), "ab");
+        }
+
+        void removeSegment(size_t index) {
+            std::error_code ec;
+            std::filesystem::remove(segments[index].path, ec);
+            segments.erase(segments.begin() + index);
+        }
+
+    public:
+        EventJournal() = default;
+        ~EventJournal() { close(); }
+
+        EventJournal(const EventJournal&) = delete;
+        EventJournal& operator=(const EventJournal&) = delete;
+
+        // Opens (or creates) the journal in `directory`, dropping any torn tail
+        bool open(const std::string& directory, JournalOptions options = JournalOptions()) {
+            std::lock_guard<std::mutex> lk(lock);
+            if (active) fclose(active);
+            active = nullptr;
+            segments.clear();
+            dir = directory;
+            opts = options;
+            next = 0;
+
+            std::error_code ec;
+            std::filesystem::create_directories(dir, ec);
+            if (!std::filesystem::is_directory(dir, ec)) return false;
+
+            for (const auto& entry : std::filesystem::directory_iterator(dir, ec)) {
+                uint64_t first = 0;
+                if (entry.is_regular_file(ec) && parseName(entry.path().filename().string(), first))
+                    segments.push_back({ first, entry.path() });
+            }
+            std::sort(segments.begin(), segments.end(), [](const Segment& a, const Segment& b) { return a.first < b.first; });
+
+            if (segments.empty()) return startSegment(0);
+
+            // Only the newest segment can have been cut short
+            Segment& last = segments.back();
+            size_t good = 0;
+            uint64_t count = 0;
+            {
+                MappedFile map;
+                if (!map.open(last.path)) return false;
+                good = walk(map.data(), map.size(), last.first, [&](uint64_t, std::string_view) { count++; });
+                if (good == map.size() && good >= HEADER) {
+                    next = last.first + count;
+                    active_bytes = good;
+                    active = fopen(last.path.string().c_str(), "ab");
+                    return active != nullptr;
+                }
+            }
+
+            next = last.first + count;
+            if (good < HEADER) {
+                // Not even a header: replace the file
+                removeSegment(segments.size() - 1);
+                return startSegment(next);
+            }
+            std::filesystem::resize_file(last.path, good, ec);
+            if (ec) return false;
+            active_bytes = good;
+            active = fopen(last.path.string().c_str(), "ab");
+            return active != nullptr;
+        }
+
+        void close() {
+            std::lock_guard<std::mutex> lk(lock);
+            if (active) fclose(active);
+            active = nullptr;
+        }
+
+        bool isOpen() const {
+            std::lock_guard<std::mutex> lk(lock);
+            return active != nullptr;
+        }
+
+        // Appends one event; false if it could not be written
+        bool append(const char* msg, size_t len) {
+            if (len > MAX_RECORD) len = MAX_RECORD;
+            std::lock_guard<std::mutex> lk(lock);
+            if (!active) return false;
+
+            if (active_bytes > HEADER && active_bytes + RECORD_HEADER + len > opts.segment_bytes) {
+                if (!startSegment(next)) return false;
+                while (opts.max_segments && segments.size() > opts.max_segments) removeSegment(0);
+            }
+
+            char head[RECORD_HEADER];
+            put32(head, (uint32_t)len);
+            put64(head + 8, next);
+            put32(head + 4, crc32(msg, len, crc32(head + 8, 8)));
+
+            if (fwrite(head, 1, RECORD_HEADER, active) != RECORD_HEADER ||
+                fwrite(msg, 1, len, active) != len ||
+                fflush(active) != 0) {
+                discardTail();
+                return false;
+            }
+            active_bytes += RECORD_HEADER + len;
+            next++;
+            return true;
+        }
+
+        bool append(const std::string& msg) { return append(msg.data(), msg.size()); }
+
+        // Offset the next event will get
+        uint64_t nextOffset() const {
+            std::lock_guard<std::mutex> lk(lock);
+            return next;
+        }
+
+        // Oldest offset still held
+        uint64_t firstOffset() const {
+            std::lock_guard<std::mutex> lk(lock);
+            return segments.empty() ? next : segments.front().first;
+        }
+
+        size_t segmentCount() const {
+            std::lock_guard<std::mutex> lk(lock);
+            return segments.size();
+        }
+
+        // Calls fn(uint64_t offset, std::string_view msg) for every event from
+        // `from` on, oldest first, reading the segments through mmap. Returns the
+        // offset to resume from next time. fn must not append to this journal.
+        template <typename Fn>
+        uint64_t replay(uint64_t from, Fn&& fn) const {
+            std::lock_guard<std::mutex> lk(lock);
+            uint64_t resume = std::max(from, segments.empty() ? next : segments.front().first);
+
+            for (size_t i = 0; i < segments.size(); i++) {
+                uint64_t end = i + 1 < segments.size() ? segments[i + 1].first : next;
+                if (end <= resume) continue;
+
+                MappedFile map;
+                if (!map.open(segments[i].path)) continue;
+                walk(map.data(), map.size(), segments[i].first, [&](uint64_t offset, std::string_view msg) {
+                    if (offset < resume || offset >= next) return;
+                    fn(offset, msg);
+                    resume = offset + 1;
+                });
+            }
+            return resume;
+        }
+
+        // Deletes segments whose events all come before `before`. The segment
+        // being appended to is kept. Returns how many were removed.
+        size_t compact(uint64_t before) {
+            std::lock_guard<std::mutex> lk(lock);
+            size_t removed = 0;
+            while (segments.size() > 1 && segments[1].first <= before) {
+                removeSegment(0);
+                removed++;
+            }
+            return removed;
+        }
+    };
+}
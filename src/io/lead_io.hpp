@@ -0,0 +1,520 @@
+#pragma once
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "../crm_core.hpp"
+
+// Lead export/import formats:
+//   .csv    RFC 4180 (fields with , " or newlines are quoted)
+//   .jsonl  one {"id","name","company","value","stage"} object per line
+//   .flxs   binary columnar snapshot (layout below)
+//
+// Writers stream rows through a large buffer, so memory does not depend on
+// the number of leads exported.
+
+namespace IO {
+
+    enum class Format { Csv, Jsonl, Snapshot };
+
+    inline bool formatFromPath(const std::string& path, Format& out) {
+        auto ends = [&](const char* ext) {
+            size_t n = strlen(ext);
+            if (path.size() < n) return false;
+            for (size_t i = 0; i < n; i++)
+                if (tolower((unsigned char)path[path.size() - n + i]) != ext[i]) return false;
+            return true;
+        };
+        if (ends(".csv")) out = Format::Csv;
+        else if (ends(".jsonl")) out = Format::Jsonl;
+        else if (ends(".flxs")) out = Format::Snapshot;
+        else return false;
+        return true;
+    }
+
+    // --- BUFFERED WRITER ---
+
+    class BufferedWriter {
+    private:
+        FILE* file = nullptr;
+        std::vector<char> buf;
+        size_t used = 0;
+        bool failed = false;
+
+        void drain() {
+            if (used && file && fwrite(buf.data(), 1, used, file) != used) failed = true;
+            used = 0;
+        }
+
+    public:
+        explicit BufferedWriter(const std::string& path, size_t capacity = 1 << 20) : buf(capacity) {
+            file = fopen(path.c_str(), "wb");
+        }
+
+        ~BufferedWriter() { close(); }
+
+        BufferedWriter(const BufferedWriter&) = delete;
+        BufferedWriter& operator=(const BufferedWriter&) = delete;
+
+        bool isOpen() const { return file != nullptr; }
+
+        void write(const char* p, size_t n) {
+            if (used + n > buf.size()) {
+                drain();
+                if (n > buf.size()) {
+                    if (file && fwrite(p, 1, n, file) != n) failed = true;
+                    return;
+                }
+            }
+            memcpy(buf.data() + used, p, n);
+            used += n;
+        }
+
+        void write(const std::string& s) { write(s.data(), s.size()); }
+
+        void put(char c) {
+            if (used == buf.size()) drain();
+            buf[used++] = c;
+        }
+
+        void writeInt(int64_t v) {
+            char tmp[24];
+            int n = snprintf(tmp, sizeof(tmp), "%lld", (long long)v);
+            write(tmp, (size_t)n);
+        }
+
+        void writeU32(uint32_t v) {
+            char b[4] = { (char)(v & 0xff), (char)((v >> 8) & 0xff), (char)((v >> 16) & 0xff), (char)(v >> 24) };
+            write(b, 4);
+        }
+
+        // Flushes and closes; false if any write failed
+        bool close() {
+            if (!file) return !failed;
+            drain();
+            if (fclose(file) != 0) failed = true;
+            file = nullptr;
+            return !failed;
+        }
+    };
+
+    // --- VARINTS ---
+
+    inline void putVarint(std::string& out, uint64_t v) {
+        while (v >= 0x80) {
+            out.push_back((char)(v | 0x80));
+            v >>= 7;
+        }
+        out.push_back((char)v);
+    }
+
+    inline uint64_t zigzag(int64_t v) { return ((uint64_t)v << 1) ^ (uint64_t)(v >> 63); }
+    inline int64_t unzigzag(uint64_t v) { return (int64_t)(v >> 1) ^ -(int64_t)(v & 1); }
+
+    inline bool getVarint(const char*& p, const char* end, uint64_t& v) {
+        v = 0;
+        for (int shift = 0; shift < 64 && p < end; shift += 7) {
+            uint8_t b = (uint8_t)*p++;
+            v |= (uint64_t)(b & 0x7f) << shift;
+            if (!(b & 0x80)) return true;
+        }
+        return false;
+    }
+
+    // --- TEXT ESCAPING ---
+
+    inline void writeCsvField(BufferedWriter& out, const std::string& s) {
+        if (s.find_first_of(",\"\r\n") == std::string::npos) { out.write(s); return; }
+        out.put('"');
+        for (char c : s) {
+            if (c == '"') out.put('"');
+            out.put(c);
+        }
+        out.put('"');
+    }
+
+    inline void writeJsonString(BufferedWriter& out, const std::string& s) {
+        out.put('"');
+        for (unsigned char c : s) {
+            switch (c) {
+                case '"':  out.write("\\\"", 2); break;
+                case '\\': out.write("\\\\", 2); break;
+                case '\n': out.write("\\n", 2); break;
+                case '\r': out.write("\\r", 2); break;
+                case '\t': out.write("\\t", 2); break;
+                default:
+                    if (c < 0x20) {
+                        char tmp[8];
+                        snprintf(tmp, sizeof(tmp), "\\u%04x", c);
+                        out.write(tmp, 6);
+                    } else out.put((char)c);
+            }
+        }
+        out.put('"');
+    }
+
+    // --- SNAPSHOT FORMAT ---
+    // "FLXSNAP1", then row groups of up to GROUP_ROWS leads:
+    //   u32 rows (0 ends the file) | u32 payload bytes | payload
+    // payload, all integers LEB128:
+    //   new stage strings    count, (len, bytes)*   codes continue across groups
+    //   new company strings  count, (len, bytes)*
+    //   id column            zigzag delta from the previous row
+    //   value column         zigzag
+    //   stage column         dictionary codes
+    //   company column       dictionary codes
+    //   name column          (len, bytes) per row
+    // After the terminator: u32 total rows.
+
+    static const char SNAPSHOT_MAGIC[8] = { 'F', 'L', 'X', 'S', 'N', 'A', 'P', '1' };
+    static const size_t GROUP_ROWS = 65536;
+
+    class SnapshotEncoder {
+    private:
+        BufferedWriter& out;
+        std::unordered_map<std::string, uint32_t> stage_codes, company_codes;
+        std::vector<std::string> new_stages, new_companies;
+        std::vector<Lead> group;
+        std::string payload;
+        uint32_t total = 0;
+
+        uint32_t code(std::unordered_map<std::string, uint32_t>& dict, std::vector<std::string>& added, const std::string& s) {
+            auto it = dict.find(s);
+            if (it != dict.end()) return it->second;
+            uint32_t c = (uint32_t)dict.size();
+            dict.emplace(s, c);
+            added.push_back(s);
+            return c;
+        }
+
+        static void putStrings(std::string& dst, const std::vector<std::string>& strs) {
+            putVarint(dst, strs.size());
+            for (const auto& s : strs) {
+                putVarint(dst, s.size());
+                dst += s;
+            }
+        }
+
+        void flushGroup() {
+            if (group.empty()) return;
+            payload.clear();
+
+            std::vector<uint32_t> stages(group.size()), companies(group.size());
+            for (size_t i = 0; i < group.size(); i++) {
+                stages[i] = code(stage_codes, new_stages, group[i].status);
+                companies[i] = code(company_codes, new_companies, group[i].company);
+            }
+            putStrings(payload, new_stages);
+            putStrings(payload, new_companies);
+            new_stages.clear();
+            new_companies.clear();
+
+            int64_t prev = 0;
+            for (const Lead& l : group) { putVarint(payload, zigzag((int64_t)l.id - prev)); prev = (int64_t)l.id; }
+            for (const Lead& l : group) putVarint(payload, zigzag(l.value));
+            for (uint32_t c : stages) putVarint(payload, c);
+            for (uint32_t c : companies) putVarint(payload, c);
+            for (const Lead& l : group) { putVarint(payload, l.name.size()); payload += l.name; }
+
+            out.writeU32((uint32_t)group.size());
+            out.writeU32((uint32_t)payload.size());
+            out.write(payload);
+            total += (uint32_t)group.size();
+            group.clear();
+        }
+
+    public:
+        explicit SnapshotEncoder(BufferedWriter& writer) : out(writer) {
+            out.write(SNAPSHOT_MAGIC, 8);
+            group.reserve(GROUP_ROWS);
+        }
+
+        void add(const Lead& l) {
+            group.push_back(l);
+            if (group.size() == GROUP_ROWS) flushGroup();
+        }
+
+        void finish() {
+            flushGroup();
+            out.writeU32(0);
+            out.writeU32(total);
+        }
+    };
+
+    class SnapshotReader {
+    private:
+        std::ifstream in;
+        std::vector<std::string> stages, companies;
+        std::vector<char> payload;
+        bool valid = false;
+        bool done = false;
+
+        bool readU32(uint32_t& v) {
+            unsigned char b[4];
+            if (!in.read((char*)b, 4)) return false;
+            v = b[0] | (b[1] << 8) | (b[2] << 16) | ((uint32_t)b[3] << 24);
+            return true;
+        }
+
+        static bool getStrings(const char*& p, const char* end, std::vector<std::string>& dst) {
+            uint64_t n, len;
+            if (!getVarint(p, end, n)) return false;
+            for (uint64_t i = 0; i < n; i++) {
+                if (!getVarint(p, end, len) || (uint64_t)(end - p) < len) return false;
+                dst.emplace_back(p, (size_t)len);
+                p += len;
+            }
+            return true;
+        }
+
+    public:
+        explicit SnapshotReader(const std::string& path) : in(path, std::ios::binary) {
+            char magic[8];
+            valid = in.read(magic, 8) && memcmp(magic, SNAPSHOT_MAGIC, 8) == 0;
+        }
+
+        bool isValid() const { return valid; }
+
+        // Decodes the next row group into `rows` (reused between calls).
+        // False at the end of the file or on corruption (then isValid() is false).
+        bool next(std::vector<Lead>& rows) {
+            rows.clear();
+            if (!valid || done) return false;
+
+            uint32_t count, bytes;
+            if (!readU32(count)) { valid = false; return false; }
+            if (count == 0) { done = true; return false; }
+            if (!readU32(bytes)) { valid = false; return false; }
+
+            payload.resize(bytes);
+            if (!in.read(payload.data(), bytes)) { valid = false; return false; }
+            const char* p = payload.data();
+            const char* end = p + bytes;
+
+            if (!getStrings(p, end, stages) || !getStrings(p, end, companies)) { valid = false; return false; }
+
+            rows.resize(count);
+            uint64_t v;
+            int64_t prev = 0;
+            bool ok = true;
+            for (uint32_t i = 0; ok && i < count; i++) {
+                ok = getVarint(p, end, v);
+                prev += unzigzag(v);
+                rows[i].id = (fluxdb::Id)prev;
+            }
+            for (uint32_t i = 0; ok && i < count; i++) { ok = getVarint(p, end, v); rows[i].value = (int)unzigzag(v); }
+            for (uint32_t i = 0; ok && i < count; i++) {
+                ok = getVarint(p, end, v) && v < stages.size();
+                if (ok) rows[i].status = stages[v];
+            }
+            for (uint32_t i = 0; ok && i < count; i++) {
+                ok = getVarint(p, end, v) && v < companies.size();
+                if (ok) rows[i].company = companies[v];
+            }
+            for (uint32_t i = 0; ok && i < count; i++) {
+                ok = getVarint(p, end, v) && (uint64_t)(end - p) >= v;
+                if (ok) { rows[i].name.assign(p, (size_t)v); p += v; }
+            }
+            if (!ok) { valid = false; rows.clear(); return false; }
+            return true;
+        }
+    };
+
+    // --- EXPORT ---
+
+    class LeadWriter {
+    private:
+        BufferedWriter out;
+        Format format;
+        std::unique_ptr<SnapshotEncoder> snapshot;
+        size_t count = 0;
+
+    public:
+        LeadWriter(const std::string& path, Format fmt) : out(path), format(fmt) {
+            if (!out.isOpen()) return;
+            if (format == Format::Csv) out.write("ID,Name,Company,Value,Stage\n", 28);
+            if (format == Format::Snapshot) snapshot = std::make_unique<SnapshotEncoder>(out);
+        }
+
+        bool isOpen() const { return out.isOpen(); }
+        size_t rows() const { return count; }
+
+        void add(const Lead& l) {
+            count++;
+            switch (format) {
+                case Format::Csv:
+                    out.writeInt((int64_t)l.id); out.put(',');
+                    writeCsvField(out, l.name); out.put(',');
+                    writeCsvField(out, l.company); out.put(',');
+                    out.writeInt(l.value); out.put(',');
+                    writeCsvField(out, l.status); out.put('\n');
+                    break;
+                case Format::Jsonl:
+                    out.write("{\"id\":", 6); out.writeInt((int64_t)l.id);
+                    out.write(",\"name\":", 8); writeJsonString(out, l.name);
+                    out.write(",\"company\":", 11); writeJsonString(out, l.company);
+                    out.write(",\"value\":", 9); out.writeInt(l.value);
+                    out.write(",\"stage\":", 9); writeJsonString(out, l.status);
+                    out.write("}\n", 2);
+                    break;
+                case Format::Snapshot:
+                    snapshot->add(l);
+                    break;
+            }
+        }
+
+        bool finish() {
+            if (snapshot) snapshot->finish();
+            return out.close();
+        }
+    };
+
+    // --- IMPORT ---
+
+    // One CSV record; quoted fields may hold commas, "" and newlines
+    inline bool readCsvRecord(std::istream& in, std::vector<std::string>& fields) {
+        fields.clear();
+        int c = in.get();
+        if (c == EOF) return false;
+
+        std::string field;
+        bool quoted = false;
+        for (; c != EOF; c = in.get()) {
+            if (quoted) {
+                if (c == '"') {
+                    if (in.peek() == '"') { field.push_back('"'); in.get(); }
+                    else quoted = false;
+                } else field.push_back((char)c);
+            }
+            else if (c == '"') quoted = true;
+            else if (c == ',') { fields.push_back(std::move(field)); field.clear(); }
+            else if (c == '\n') break;
+            else if (c != '\r') field.push_back((char)c);
+        }
+        fields.push_back(std::move(field));
+        return true;
+    }
+
+    // Flat JSON object of strings and integers, as written by LeadWriter
+    inline bool parseJsonLead(const std::string& line, Lead& l) {
+        size_t p = 0;
+        auto ws = [&]() { while (p < line.size() && isspace((unsigned char)line[p])) p++; };
+        auto str = [&](std::string& out) {
+            out.clear();
+            if (p >= line.size() || line[p] != '"') return false;
+            for (p++; p < line.size() && line[p] != '"'; p++) {
+                char c = line[p];
+                if (c != '\\') { out.push_back(c); continue; }
+                if (++p >= line.size()) return false;
+                switch (line[p]) {
+                    case 'n': out.push_back('\n'); break;
+                    case 'r': out.push_back('\r'); break;
+                    case 't': out.push_back('\t'); break;
+                    case 'u':
+                        if (p + 4 >= line.size()) return false;
+                        out.push_back((char)std::stoi(line.substr(p + 1, 4), nullptr, 16)); // control chars only
+                        p += 4;
+                        break;
+                    default: out.push_back(line[p]);
+                }
+            }
+            return p++ < line.size();
+        };
+
+        ws();
+        if (p >= line.size() || line[p++] != '{') return false;
+        std::string key, text;
+        while (true) {
+            ws();
+            if (p < line.size() && line[p] == '}') return true;
+            if (!str(key)) return false;
+            ws();
+            if (p >= line.size() || line[p++] != ':') return false;
+            ws();
+            if (p < line.size() && line[p] == '"') {
+                if (!str(text)) return false;
+                if (key == "name") l.name = text;
+                else if (key == "company") l.company = text;
+                else if (key == "stage") l.status = text;
+            } else {
+                size_t start = p;
+                while (p < line.size() && (isdigit((unsigned char)line[p]) || line[p] == '-')) p++;
+                if (start == p) return false;
+                long long v = std::stoll(line.substr(start, p - start));
+                if (key == "id") l.id = (fluxdb::Id)v;
+                else if (key == "value") l.value = (int)v;
+            }
+            ws();
+            if (p < line.size() && line[p] == ',') p++;
+        }
+    }
+
+    // Yields leads from any export format, plus the legacy "name,company,value" CSV
+    class LeadReader {
+    private:
+        Format format;
+        std::ifstream text;
+        std::vector<char> text_buf;
+        std::unique_ptr<SnapshotReader> snapshot;
+        std::vector<Lead> group;
+        size_t group_pos = 0;
+        std::vector<std::string> fields;
+        std::string line;
+        bool has_id_column = false;
+        bool ok = false;
+
+    public:
+        LeadReader(const std::string& path, Format fmt) : format(fmt), text_buf(1 << 20) {
+            if (format == Format::Snapshot) {
+                snapshot = std::make_unique<SnapshotReader>(path);
+                ok = snapshot->isValid();
+                return;
+            }
+            text.rdbuf()->pubsetbuf(text_buf.data(), (std::streamsize)text_buf.size());
+            text.open(path, std::ios::binary);
+            ok = text.is_open();
+            if (ok && format == Format::Csv && readCsvRecord(text, fields))
+                has_id_column = !fields.empty() && (fields[0] == "ID" || fields[0] == "id");
+        }
+
+        bool isOpen() const { return ok; }
+
+        // False at the end; rows that fail to parse are skipped
+        bool next(Lead& l) {
+            while (ok) {
+                l = Lead();
+                if (format == Format::Snapshot) {
+                    if (group_pos == group.size()) {
+                        if (!snapshot->next(group)) return false;
+                        group_pos = 0;
+                    }
+                    l = std::move(group[group_pos++]);
+                    return true;
+                }
+                if (format == Format::Jsonl) {
+                    if (!std::getline(text, line)) return false;
+                    try { if (parseJsonLead(line, l)) return true; } catch (...) {}
+                    continue;
+                }
+
+                if (!readCsvRecord(text, fields)) return false;
+                size_t base = has_id_column ? 1 : 0;
+                if (fields.size() < base + 3) continue;
+                l.name = fields[base];
+                l.company = fields[base + 1];
+                try { l.value = std::stoi(fields[base + 2]); } catch (...) { l.value = 0; }
+                if (fields.size() > base + 3) l.status = fields[base + 3];
+                return true;
+            }
+            return false;
+        }
+
+        // Set if a snapshot turned out to be truncated or corrupt
+        bool corrupt() const { return snapshot && !snapshot->isValid(); }
+    };
+}
@@ -1,6 +1,8 @@
 #include <winsock2.h>
 #include <windows.h>
+#include <csignal>
 #include <iostream>
+#include <fstream>
 #include <string>
 
 // GUI 
@@ -14,28 +16,172 @@
 // CLI 
 #include "cli/cli_host.hpp"
 
+// Gateway
+#include "gateway/gateway_host.hpp"
+
+#include "alloc_counter.hpp"
+
+static std::atomic<bool> g_stop{false};
+
+static void onSignal(int) { g_stop = true; }
+
+// Writes the span recording (--spans or F9) as Chrome trace JSON
+static void dumpSpans(const std::string& path) {
+    fluxdb::SpanRecorder::stop();
+    long long spans = fluxdb::SpanRecorder::dump(path);
+    if (spans < 0) std::cerr << "Could not write spans to " << path << "\n";
+    else std::cout << "Wrote " << spans << " spans to " << path << "\n";
+}
+
 int main(int argc, char** argv) {
 
     bool cli_mode = false;
+    bool idle_mode = true;
+    bool alloc_stats = false;
+    std::string batch_file;
+    std::string journal_dir;
+    bool stop_on_error = true;
+    bool serve_mode = false;
+    Gateway::GatewayConfig gateway;
+    std::string spans_path = "flux_spans.json";
     for (int i = 1; i < argc; i++) {
         std::string arg = argv[i];
         if (arg == "--cli" || arg == "-c") {
             cli_mode = true;
         }
+        else if (arg == "--no-idle") {
+            idle_mode = false;
+        }
+        else if (arg == "--alloc-stats") {
+            alloc_stats = CRM::AllocStatsAvailable();
+            if (!alloc_stats) std::cerr << "--alloc-stats needs a build with FLUX_ALLOC_STATS; ignored\n";
+        }
+        else if (arg == "--batch" && i + 1 < argc) {
+            // Run a command script ("-" = stdin) with pipelined writes, then exit
+            batch_file = argv[++i];
+            cli_mode = true;
+        }
+        else if (arg == "--continue-on-error") {
+            stop_on_error = false;
+        }
+        else if (arg == "--text-protocol") {
+            // Skip binary protocol negotiation (compare against, or talk to, older servers)
+            fluxdb::FluxDBClient::defaultProtocol() = fluxdb::FluxDBClient::Protocol::Text;
+        }
+        else if (arg == "--journal" && i + 1 < argc) {
+            // Keep received events on disk and show the last session's on startup
+            journal_dir = argv[++i];
+        }
+        else if (arg == "--trace" && i + 1 < argc) {
+            // Record every command this session sends, for tools/flux_replay
+            auto writer = std::make_shared<fluxdb::TraceWriter>(argv[++i]);
+            if (writer->isOpen()) fluxdb::TraceWriter::install(writer);
+            else std::cerr << "Could not open trace file " << argv[i] << "\n";
+        }
+        else if (arg == "--spans" && i + 1 < argc) {
+            // Record timeline spans from startup; written as Chrome trace JSON on exit
+            spans_path = argv[++i];
+            fluxdb::SpanRecorder::start();
+        }
+        else if (arg == "--serve" && i + 1 < argc) {
+            // Run as a local gateway that shares upstream connections between clients
+            gateway.port = std::atoi(argv[++i]);
+            serve_mode = true;
+        }
+        else if (arg == "--upstream" && i + 1 < argc) {
+            gateway.upstream = argv[++i];
+        }
+        else if (arg == "--password" && i + 1 < argc) {
+            gateway.password = argv[++i];
+        }
+        else if (arg == "--pool" && i + 1 < argc) {
+            gateway.pool_size = std::strtoul(argv[++i], nullptr, 10);
+        }
+        else if (arg == "--cache-ms" && i + 1 < argc) {
+            gateway.cache_ms = std::atoi(argv[++i]);
+        }
+        else if (arg == "--verbose") {
+            gateway.verbose = true;
+        }
+    }
+
+    fluxdb::SpanRecorder::nameThread("main");
+    struct SpanGuard {
+        const std::string& path;
+        ~SpanGuard() { if (fluxdb::SpanRecorder::enabled()) dumpSpans(path); }
+    } span_guard{ spans_path };
+
+    // Large FIND replies decode on the shared worker pool rather than fresh threads
+    fluxdb::FluxDBClient::decodeExecutor() = [](size_t n, const std::function<void(size_t, size_t)>& fn) {
+        Query::TaskPool::shared().parallelFor(n, 1, fn);
+    };
+
+    if (serve_mode) {
+        // --- GATEWAY MODE ---
+        Gateway::GatewayHost host(gateway);
+        if (!host.start()) { std::cerr << "Could not listen on port " << gateway.port << "\n"; return 1; }
+        std::cout << "[gateway] Listening on 127.0.0.1:" << host.port() << " -> " << gateway.upstream << "\n";
+
+        std::signal(SIGINT, onSignal);
+        std::signal(SIGTERM, onSignal);
+        while (!g_stop) std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+        host.stop();
+        std::cout << "[gateway] " << host.statsText();
+        return 0;
     }
 
     if (cli_mode) {
         // --- CLI MODE ---
         CLI::CLIHost host;
+        if (batch_file == "-") return host.runBatch(std::cin, stop_on_error);
+        if (!batch_file.empty()) {
+            std::ifstream script(batch_file);
+            if (!script.is_open()) { std::cerr << "Could not open batch file " << batch_file << "\n"; return 1; }
+            return host.runBatch(script, stop_on_error);
+        }
         host.run();
     } 
     else {
         // --- GUI MODE ---
         CRM::AppHost app(L"FluxCRM", 1280, 900);
         ImPlot::CreateContext();
+        IO::EventJournal journal; // outlives state, whose ticker appends to it
         UI::AppState state;
+        state.show_alloc_stats = alloc_stats;
+        if (!journal_dir.empty()) {
+            if (journal.open(journal_dir)) {
+                state.ticker.setJournal(&journal);
+                state.ticker.loadHistory();
+            } else {
+                std::cerr << "Could not open journal " << journal_dir << "\n";
+            }
+        }
+
+        // Idle mode: only draw on input, ticker events or the midnight rollover
+        UI::FramePacer& pacer = app.Pacer();
+        pacer.SetIdleEnabled(idle_mode);
+        state.ticker.setListener([&pacer]() { pacer.Notify(); });
+        state.details.setListener([&pacer]() { pacer.Notify(); });
+        double next_rollover = UI::FramePacer::Now() + UI::FramePacer::SecondsUntilMidnight();
 
+        uint64_t allocs_before = CRM::ThreadAllocations();
         while (app.NewFrame()) {
+            FLUX_SPAN("frame");
+            // F9 starts a span recording; pressing it again writes it out
+            if (ImGui::IsKeyPressed(ImGuiKey_F9, false)) {
+                if (fluxdb::SpanRecorder::enabled()) dumpSpans(spans_path);
+                else fluxdb::SpanRecorder::start();
+            }
+
+            double now = UI::FramePacer::Now();
+            if (now >= next_rollover) next_rollover = now + UI::FramePacer::SecondsUntilMidnight();
+            pacer.ScheduleAt(next_rollover);
+            {
+                FLUX_SPAN("ui.begin_frame");
+                state.BeginFrame(now);
+            }
+
             UI::RenderSidebar(state);
             if (state.is_connected) {
                 UI::RenderPipeline(state);   
@@ -43,7 +189,14 @@ int main(int argc, char** argv) {
                 UI::RenderStatusBar(state);  
             }
             if (state.reset_layout) state.reset_layout = false;
-            app.Render();
+            {
+                FLUX_SPAN("ui.present");
+                app.Render();
+            }
+
+            uint64_t allocs_now = CRM::ThreadAllocations();
+            state.frame_allocs = allocs_now - allocs_before;
+            allocs_before = allocs_now;
         }
         ImPlot::DestroyContext();
     }
@@ -0,0 +1,239 @@
+#pragma once
+#include "../crm_core.hpp"
+#include "task_pool.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdint>
+#include <numeric>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Near-duplicate lead detection. Name and company are normalized ("ACME,
+// Inc." -> "acme"), cut into character trigrams and summarized by a MinHash
+// signature whose agreement estimates the trigram Jaccard similarity.
+// Signatures are split into LSH bands; only leads sharing a band bucket are
+// compared, so finding duplicates is near-linear instead of all pairs.
+
+namespace Query {
+
+    class DuplicateIndex {
+    public:
+        static const int HASHES = 64;
+        static const int BANDS = 16;
+        static const int ROWS = HASHES / BANDS;
+        static constexpr double DEFAULT_THRESHOLD = 0.6; // catches typos, not different first names
+
+        struct Signature {
+            uint32_t h[HASHES];
+            bool empty = true;  // nothing left after normalizing; never matches
+        };
+
+    private:
+        double threshold;
+        std::vector<Signature> sigs;
+        std::unordered_map<uint64_t, std::vector<uint32_t>> buckets[BANDS];
+
+        static const size_t MAX_BUCKET_CHECKS = 64; // newest members compared per bucket
+
+        static uint64_t mix(uint64_t x) {
+            x ^= x >> 33; x *= 0xff51afd7ed558ccdULL;
+            x ^= x >> 33; x *= 0xc4ceb9fe1a85ec53ULL;
+            x ^= x >> 33;
+            return x;
+        }
+
+        // Odd multipliers for the multiply-shift hash family, one per MinHash
+        static const uint64_t* multipliers() {
+            static const auto table = [] {
+                std::vector<uint64_t> m(HASHES);
+                for (int i = 0; i < HASHES; i++) m[i] = mix(0x9e3779b97f4a7c15ULL * (i + 1)) | 1;
+                return m;
+            }();
+            return table.data();
+        }
+
+        static uint64_t bandKey(const Signature& s, int band) {
+            uint64_t k = (uint64_t)band * 0x9e3779b97f4a7c15ULL;
+            for (int r = 0; r < ROWS; r++) k = mix(k ^ s.h[band * ROWS + r]);
+            return k;
+        }
+
+    public:
+        explicit DuplicateIndex(double similarity = DEFAULT_THRESHOLD) : threshold(similarity) {}
+
+        // Lowercase words of letters/digits, minus legal-form suffixes
+        static std::string normalize(const std::string& s) {
+            static const char* SUFFIXES[] = { "inc", "incorporated", "llc", "ltd", "limited", "corp", "corporation",
+                                              "co", "company", "gmbh", "ag", "sa", "plc", "the" };
+            std::string out, word;
+            auto flush = [&]() {
+                if (word.empty()) return;
+                for (const char* suf : SUFFIXES) if (word == suf) { word.clear(); return; }
+                if (!out.empty()) out += ' ';
+                out += word;
+                word.clear();
+            };
+            for (char ch : s) {
+                unsigned char c = (unsigned char)ch;
+                if (c >= 0x80 || isalnum(c)) word += (char)tolower(c);
+                else if (c != '\'' && c != '.') flush(); // "O'Neil", "A.C.M.E" stay one word
+            }
+            flush();
+            return out;
+        }
+
+        static Signature signature(const std::string& name, const std::string& company) {
+            Signature sig;
+            std::fill(std::begin(sig.h), std::end(sig.h), UINT32_MAX);
+
+            std::string norm_name = normalize(name), norm_company = normalize(company);
+            if (norm_name.empty() && norm_company.empty()) return sig;
+            std::string text = " " + norm_name + " | " + norm_company + " ";
+
+            const uint64_t* m = multipliers();
+            for (size_t i = 0; i + 3 <= text.size(); i++) {
+                uint64_t x = mix(((uint64_t)(uint8_t)text[i] << 16) | ((uint64_t)(uint8_t)text[i + 1] << 8) | (uint8_t)text[i + 2]);
+                for (int k = 0; k < HASHES; k++) {
+                    uint32_t h = (uint32_t)((m[k] * x) >> 32);
+                    if (h < sig.h[k]) sig.h[k] = h;
+                }
+            }
+            sig.empty = false;
+            return sig;
+        }
+
+        // Estimated Jaccard similarity: the fraction of agreeing MinHashes
+        static double similarity(const Signature& a, const Signature& b) {
+            if (a.empty || b.empty) return 0.0;
+            int same = 0;
+            for (int k = 0; k < HASHES; k++) same += a.h[k] == b.h[k];
+            return (double)same / HASHES;
+        }
+
+        // similarity(a, b) >= threshold, giving up as soon as too many hashes differ
+        static bool similar(const Signature& a, const Signature& b, double threshold) {
+            if (a.empty || b.empty) return false;
+            int allowed = HASHES - (int)std::ceil(threshold * HASHES);
+            for (int k = 0; k < HASHES; k++)
+                if (a.h[k] != b.h[k] && --allowed < 0) return false;
+            return true;
+        }
+
+        static std::vector<Signature> signatures(const std::vector<Lead>& leads, TaskPool& pool = TaskPool::shared()) {
+            std::vector<Signature> out(leads.size());
+            pool.parallelFor(leads.size(), 1024, [&](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; i++) out[i] = signature(leads[i].name, leads[i].company);
+            });
+            return out;
+        }
+
+        // --- INCREMENTAL (import) ---
+
+        size_t size() const { return sigs.size(); }
+
+        // Row number of the most similar indexed lead at or above the threshold, or -1
+        int64_t match(const Signature& s) const {
+            if (s.empty) return -1;
+            int64_t best = -1;
+            double best_sim = threshold;
+            for (int b = 0; b < BANDS; b++) {
+                auto it = buckets[b].find(bandKey(s, b));
+                if (it == buckets[b].end()) continue;
+                const auto& rows = it->second;
+                size_t from = rows.size() > MAX_BUCKET_CHECKS ? rows.size() - MAX_BUCKET_CHECKS : 0;
+                for (size_t i = from; i < rows.size(); i++) {
+                    if (!similar(s, sigs[rows[i]], best_sim)) continue;
+                    double sim = similarity(s, sigs[rows[i]]);
+                    if (best < 0 || sim > best_sim || (sim == best_sim && rows[i] < best)) {
+                        best = rows[i];
+                        best_sim = sim;
+                    }
+                }
+            }
+            return best;
+        }
+
+        uint32_t add(const Signature& s) {
+            uint32_t row = (uint32_t)sigs.size();
+            sigs.push_back(s);
+            if (!s.empty)
+                for (int b = 0; b < BANDS; b++) buckets[b][bandKey(s, b)].push_back(row);
+            return row;
+        }
+
+        // --- BATCH (DEDUPE) ---
+
+        // Groups of two or more similar rows, each sorted, largest groups first.
+        // Bands are bucketed in parallel by sorting packed (key, row) words; inside a
+        // bucket every row is compared with the bucket's first row and its
+        // predecessor, so the work stays linear even for big buckets.
+        static std::vector<std::vector<uint32_t>> clusters(const std::vector<Signature>& sigs, double threshold, TaskPool& pool = TaskPool::shared()) {
+            size_t n = sigs.size();
+            std::vector<std::vector<std::pair<uint32_t, uint32_t>>> band_pairs(BANDS);
+
+            pool.parallelFor(BANDS, 1, [&](size_t first, size_t last) {
+                // (32-bit band key << 32 | row): sorting plain integers is much
+                // faster than pairs, and the rare key collision only costs a
+                // comparison that similar() then rejects
+                std::vector<uint64_t> keyed;
+                keyed.reserve(n);
+                for (int b = (int)first; b < (int)last; b++) {
+                    keyed.clear();
+                    for (uint32_t r = 0; r < n; r++)
+                        if (!sigs[r].empty) keyed.push_back((bandKey(sigs[r], b) & 0xffffffff00000000ULL) | r);
+                    std::sort(keyed.begin(), keyed.end());
+
+                    auto& pairs = band_pairs[b];
+                    for (size_t i = 0; i < keyed.size();) {
+                        size_t j = i + 1;
+                        while (j < keyed.size() && (keyed[j] >> 32) == (keyed[i] >> 32)) j++;
+                        uint32_t leader = (uint32_t)keyed[i];
+                        for (size_t k = i + 1; k < j; k++) {
+                            uint32_t r = (uint32_t)keyed[k], prev = (uint32_t)keyed[k - 1];
+                            if (similar(sigs[leader], sigs[r], threshold)) pairs.push_back({ leader, r });
+                            else if (prev != leader && similar(sigs[prev], sigs[r], threshold)) pairs.push_back({ prev, r });
+                        }
+                        i = j;
+                    }
+                }
+            });
+
+            // Union-find over the candidate pairs
+            std::vector<uint32_t> parent(n);
+            std::iota(parent.begin(), parent.end(), 0u);
+            auto find = [&](uint32_t x) {
+                while (parent[x] != x) x = parent[x] = parent[parent[x]];
+                return x;
+            };
+            for (const auto& pairs : band_pairs)
+                for (const auto& [a, b] : pairs) {
+                    uint32_t ra = find(a), rb = find(b);
+                    if (ra != rb) parent[std::max(ra, rb)] = std::min(ra, rb);
+                }
+
+            // Roots are the smallest row of their group, so rows come out sorted
+            std::vector<uint32_t> group_size(n, 0);
+            for (uint32_t r = 0; r < n; r++) group_size[find(r)]++;
+            std::unordered_map<uint32_t, size_t> slot;
+            std::vector<std::vector<uint32_t>> out;
+            for (uint32_t r = 0; r < n; r++) {
+                uint32_t root = find(r);
+                if (group_size[root] < 2) continue;
+                auto it = slot.find(root);
+                if (it == slot.end()) {
+                    it = slot.emplace(root, out.size()).first;
+                    out.emplace_back();
+                    out.back().reserve(group_size[root]);
+                }
+                out[it->second].push_back(r);
+            }
+            std::sort(out.begin(), out.end(), [](const auto& a, const auto& b) {
+                return a.size() != b.size() ? a.size() > b.size() : a.front() < b.front();
+            });
+            return out;
+        }
+    };
+}
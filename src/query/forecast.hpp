@@ -0,0 +1,246 @@
+#pragma once
+#include "../../vendor/fluxdb/document.hpp"
+#include "task_pool.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Weighted revenue forecast over a local snapshot of every lead.
+//
+// Conversion rates come from the funnel: of the leads that reached a stage,
+// the share that moved past it. Each rate is a Beta posterior (uniform
+// prior), so a small pipeline gives wide bands rather than overconfident
+// ones. A lead's expected revenue is its value times its chance of ending
+// Won. The Monte Carlo bands redraw both rates per trial and then every open
+// lead's outcome, over fixed-size blocks of leads on the TaskPool. Results
+// do not depend on the thread count, so an unchanged snapshot never flickers.
+
+namespace Query {
+
+    const int FORECAST_STAGES = 3; // New, Contacted, Won
+
+    struct ForecastResult {
+        size_t count[FORECAST_STAGES] = {};
+        double pipeline[FORECAST_STAGES] = {};  // raw value per stage
+        double win_rate[FORECAST_STAGES] = {};  // chance a lead in the stage ends Won
+        double expected[FORECAST_STAGES] = {};  // pipeline * win_rate
+        double low[FORECAST_STAGES] = {};       // P10 of won revenue per stage
+        double high[FORECAST_STAGES] = {};      // P90
+        double expected_total = 0.0;
+        double low_total = 0.0, median_total = 0.0, high_total = 0.0;
+        int trials = 0;
+        double compute_ms = 0.0;
+    };
+
+    class Forecaster {
+    public:
+        static const int DEFAULT_TRIALS = 1000;
+
+    private:
+        static const size_t BLOCK = 16384; // leads per Monte Carlo task, sized for L2
+
+        struct Column {
+            std::vector<int32_t> values;
+            std::vector<fluxdb::Id> ids;
+            int64_t sum = 0;
+        };
+
+        struct Slot {
+            uint8_t stage;
+            uint32_t row;
+        };
+
+        Column columns[FORECAST_STAGES];
+        std::unordered_map<fluxdb::Id, Slot> where;
+        ForecastResult cached;
+        bool dirty = true;
+
+        static uint64_t splitmix(uint64_t& state) {
+            uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+            return z ^ (z >> 31);
+        }
+
+        static double betaSample(std::mt19937_64& rng, double a, double b) {
+            double x = std::gamma_distribution<double>(a, 1.0)(rng);
+            double y = std::gamma_distribution<double>(b, 1.0)(rng);
+            return x + y > 0 ? x / (x + y) : 0.5;
+        }
+
+        // Sum of the values in [begin, end) whose draw falls under threshold (p * 2^32)
+        static int64_t wonSum(const int32_t* values, size_t begin, size_t end, uint64_t threshold, uint64_t seed) {
+            // Branch-free (outcomes are coin flips the predictor cannot learn),
+            // two 32-bit draws per 64-bit hash
+            int64_t sum = 0;
+            size_t i = begin;
+            for (; i + 2 <= end; i += 2) {
+                uint64_t x = splitmix(seed);
+                sum += values[i] & -(int32_t)((x >> 32) < threshold);
+                sum += values[i + 1] & -(int32_t)((x & 0xffffffffULL) < threshold);
+            }
+            if (i < end) sum += values[i] & -(int32_t)((splitmix(seed) >> 32) < threshold);
+            return sum;
+        }
+
+        // P-th percentile (0..1) of xs, reordering it
+        static double percentile(std::vector<double>& xs, double p) {
+            if (xs.empty()) return 0.0;
+            size_t k = std::min(xs.size() - 1, (size_t)(p * (xs.size() - 1) + 0.5));
+            std::nth_element(xs.begin(), xs.begin() + k, xs.end());
+            return xs[k];
+        }
+
+    public:
+        // Stage column for a status, or -1 for statuses outside the funnel
+        static int stageIndex(const std::string& stage) {
+            if (stage == "New") return 0;
+            if (stage == "Contacted") return 1;
+            if (stage == "Won") return 2;
+            return -1;
+        }
+
+        size_t size() const { return where.size(); }
+
+        void clear() {
+            for (auto& c : columns) c = Column();
+            where.clear();
+            dirty = true;
+        }
+
+        // Adds a lead or moves it to its new stage/value
+        void upsert(fluxdb::Id id, const std::string& stage, int value) {
+            int s = stageIndex(stage);
+            if (s < 0) { remove(id); return; }
+
+            auto it = where.find(id);
+            if (it != where.end()) {
+                Column& c = columns[it->second.stage];
+                if (it->second.stage == s) {
+                    int32_t& v = c.values[it->second.row];
+                    c.sum += (int64_t)value - v;
+                    v = value;
+                    dirty = true;
+                    return;
+                }
+                remove(id);
+            }
+            Column& c = columns[s];
+            where[id] = { (uint8_t)s, (uint32_t)c.values.size() };
+            c.values.push_back(value);
+            c.ids.push_back(id);
+            c.sum += value;
+            dirty = true;
+        }
+
+        // Partial update of a known lead (either may be null); false if it is not in the snapshot
+        bool patch(fluxdb::Id id, const std::string* stage, const int* value) {
+            auto it = where.find(id);
+            if (it == where.end()) return false;
+            static const char* NAMES[FORECAST_STAGES] = { "New", "Contacted", "Won" };
+            const Column& c = columns[it->second.stage];
+            int v = value ? *value : c.values[it->second.row];
+            upsert(id, stage ? *stage : NAMES[it->second.stage], v);
+            return true;
+        }
+
+        bool remove(fluxdb::Id id) {
+            auto it = where.find(id);
+            if (it == where.end()) return false;
+
+            // Swap the last row of the column into the hole
+            Column& c = columns[it->second.stage];
+            uint32_t row = it->second.row;
+            c.sum -= c.values[row];
+            c.values[row] = c.values.back();
+            c.ids[row] = c.ids.back();
+            if (c.ids[row] != id) where[c.ids[row]].row = row;
+            c.values.pop_back();
+            c.ids.pop_back();
+            where.erase(it);
+            dirty = true;
+            return true;
+        }
+
+        // Recomputes only if the snapshot changed since the last call
+        const ForecastResult& compute(int trials = DEFAULT_TRIALS, TaskPool& pool = TaskPool::shared()) {
+            if (!dirty && cached.trials == trials) return cached;
+            auto t0 = std::chrono::steady_clock::now();
+            trials = std::max(trials, 1);
+
+            ForecastResult r;
+            r.trials = trials;
+            for (int s = 0; s < FORECAST_STAGES; s++) {
+                r.count[s] = columns[s].values.size();
+                r.pipeline[s] = (double)columns[s].sum;
+            }
+
+            // Beta(successes + 1, failures + 1) for New -> Contacted and Contacted -> Won
+            double nc_a = (double)(r.count[1] + r.count[2]) + 1.0, nc_b = (double)r.count[0] + 1.0;
+            double cw_a = (double)r.count[2] + 1.0, cw_b = (double)r.count[1] + 1.0;
+            double p_nc = nc_a / (nc_a + nc_b), p_cw = cw_a / (cw_a + cw_b);
+            r.win_rate[0] = p_nc * p_cw;
+            r.win_rate[1] = p_cw;
+            r.win_rate[2] = 1.0;
+            for (int s = 0; s < FORECAST_STAGES; s++) {
+                r.expected[s] = r.pipeline[s] * r.win_rate[s];
+                r.expected_total += r.expected[s];
+            }
+
+            // Per-trial rates, drawn up front so the outcome is independent of scheduling
+            std::mt19937_64 rng(0x5eedf00dULL);
+            std::vector<uint64_t> threshold[2];
+            for (auto& t : threshold) t.resize(trials);
+            for (int t = 0; t < trials; t++) {
+                double nc = betaSample(rng, nc_a, nc_b), cw = betaSample(rng, cw_a, cw_b);
+                threshold[0][t] = (uint64_t)(nc * cw * 4294967296.0);
+                threshold[1][t] = (uint64_t)(cw * 4294967296.0);
+            }
+
+            // Open leads in fixed blocks; each block adds its won value per trial
+            struct Block { int stage; size_t begin, end; };
+            std::vector<Block> blocks;
+            for (int s = 0; s < 2; s++)
+                for (size_t b = 0; b < columns[s].values.size(); b += BLOCK)
+                    blocks.push_back({ s, b, std::min(columns[s].values.size(), b + BLOCK) });
+
+            std::vector<int64_t> partial(blocks.size() * trials);
+            pool.parallelFor(blocks.size(), 1, [&](size_t begin, size_t end) {
+                for (size_t k = begin; k < end; k++) {
+                    const Block& b = blocks[k];
+                    const int32_t* values = columns[b.stage].values.data();
+                    int64_t* out = &partial[k * trials];
+                    for (int t = 0; t < trials; t++) {
+                        uint64_t seed = ((uint64_t)t << 32) ^ (k * 0xd1b54a32d192ed03ULL);
+                        out[t] = wonSum(values, b.begin, b.end, threshold[b.stage][t], seed);
+                    }
+                }
+            });
+
+            std::vector<double> stage_won[2], totals(trials);
+            for (auto& v : stage_won) v.assign(trials, 0.0);
+            for (size_t k = 0; k < blocks.size(); k++)
+                for (int t = 0; t < trials; t++) stage_won[blocks[k].stage][t] += (double)partial[k * trials + t];
+            for (int t = 0; t < trials; t++) totals[t] = r.pipeline[2] + stage_won[0][t] + stage_won[1][t];
+
+            for (int s = 0; s < 2; s++) {
+                r.low[s] = percentile(stage_won[s], 0.1);
+                r.high[s] = percentile(stage_won[s], 0.9);
+            }
+            r.low[2] = r.high[2] = r.pipeline[2];
+            r.low_total = percentile(totals, 0.1);
+            r.median_total = percentile(totals, 0.5);
+            r.high_total = percentile(totals, 0.9);
+
+            r.compute_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+            cached = r;
+            dirty = false;
+            return cached;
+        }
+    };
+}
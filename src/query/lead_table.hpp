@@ -0,0 +1,466 @@
+#pragma once
+#include "../crm_core.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <cctype>
+#include <limits>
+#include <queue>
+#include <string>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define FLUX_QUERY_SSE2 1
+#endif
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+// Local query engine over a columnar snapshot of all leads.
+// Filters run as branch-free bitmap kernels (AVX2 or SSE2 where available), sorting
+// follows ValueLess: numbers numerically, strings lexicographically.
+
+namespace Query {
+
+    // --- DICTIONARY ---
+    // Codes are assigned in sorted order, so comparing codes compares strings
+    // and string range predicates become code ranges.
+
+    class Dictionary {
+    private:
+        std::vector<std::string> sorted;
+
+    public:
+        // Returns per-row codes for the given strings
+        std::vector<int32_t> build(const std::vector<const std::string*>& rows) {
+            sorted.clear();
+            for (const std::string* s : rows) sorted.push_back(*s);
+            std::sort(sorted.begin(), sorted.end());
+            sorted.erase(std::unique(sorted.begin(), sorted.end()), sorted.end());
+
+            std::vector<int32_t> codes(rows.size());
+            for (size_t i = 0; i < rows.size(); i++) codes[i] = code(*rows[i]);
+            return codes;
+        }
+
+        int32_t code(const std::string& s) const {
+            auto it = std::lower_bound(sorted.begin(), sorted.end(), s);
+            return (it != sorted.end() && *it == s) ? (int32_t)(it - sorted.begin()) : -1;
+        }
+
+        // First code whose string is >= s (may be size())
+        int32_t lowerBound(const std::string& s) const {
+            return (int32_t)(std::lower_bound(sorted.begin(), sorted.end(), s) - sorted.begin());
+        }
+
+        // First code whose string is > s
+        int32_t upperBound(const std::string& s) const {
+            return (int32_t)(std::upper_bound(sorted.begin(), sorted.end(), s) - sorted.begin());
+        }
+
+        const std::string& str(int32_t c) const { return sorted[c]; }
+        size_t size() const { return sorted.size(); }
+    };
+
+    // --- SELECTION BITMAP ---
+    // One bit per row, 64 rows per word. Filters AND into it; words that are
+    // already zero are skipped without touching the column.
+
+    inline int popcount64(uint64_t w) {
+#if defined(_MSC_VER) && !defined(__clang__)
+        return (int)__popcnt64(w);
+#else
+        return __builtin_popcountll(w);
+#endif
+    }
+
+    inline int lowestBit(uint64_t w) {
+#if defined(_MSC_VER) && !defined(__clang__)
+        unsigned long idx;
+        _BitScanForward64(&idx, w);
+        return (int)idx;
+#else
+        return __builtin_ctzll(w);
+#endif
+    }
+
+    class Selection {
+    public:
+        std::vector<uint64_t> words;
+        size_t rows = 0;
+
+        explicit Selection(size_t n) : words((n + 63) / 64, ~0ull), rows(n) {
+            if (n % 64) words.back() = (1ull << (n % 64)) - 1;
+        }
+
+        size_t count() const {
+            size_t c = 0;
+            for (uint64_t w : words) c += popcount64(w);
+            return c;
+        }
+
+        template <typename Fn>
+        void forEach(Fn fn) const {
+            for (size_t wi = 0; wi < words.size(); wi++) {
+                for (uint64_t w = words[wi]; w; w &= w - 1) fn((uint32_t)(wi * 64 + lowestBit(w)));
+            }
+        }
+
+        // Clears rows where keep(row) is false
+        template <typename Fn>
+        void refine(Fn keep) {
+            for (size_t wi = 0; wi < words.size(); wi++) {
+                for (uint64_t w = words[wi]; w; w &= w - 1) {
+                    int bit = lowestBit(w);
+                    if (!keep((uint32_t)(wi * 64 + bit))) words[wi] &= ~(1ull << bit);
+                }
+            }
+        }
+    };
+
+    // --- FILTER KERNELS ---
+    // Bits of 64 rows where lo <= col[i] <= hi
+
+    inline uint64_t rangeBitsScalar(const int32_t* col, size_t count, int32_t lo, int32_t hi) {
+        uint64_t bits = 0;
+        for (size_t i = 0; i < count; i++) bits |= (uint64_t)((col[i] >= lo) & (col[i] <= hi)) << i;
+        return bits;
+    }
+
+    inline uint64_t rangeBits64(const int32_t* col, int32_t lo, int32_t hi) {
+#if defined(__AVX2__)
+        const __m256i vlo = _mm256_set1_epi32(lo);
+        const __m256i vhi = _mm256_set1_epi32(hi);
+        uint64_t bits = 0;
+        for (int k = 0; k < 8; k++) {
+            __m256i x = _mm256_loadu_si256((const __m256i*)(col + k * 8));
+            __m256i outside = _mm256_or_si256(_mm256_cmpgt_epi32(vlo, x), _mm256_cmpgt_epi32(x, vhi));
+            uint32_t out = (uint32_t)_mm256_movemask_ps(_mm256_castsi256_ps(outside));
+            bits |= (uint64_t)(~out & 0xffu) << (k * 8);
+        }
+        return bits;
+#elif defined(FLUX_QUERY_SSE2)
+        const __m128i vlo = _mm_set1_epi32(lo);
+        const __m128i vhi = _mm_set1_epi32(hi);
+        uint64_t bits = 0;
+        for (int k = 0; k < 16; k++) {
+            __m128i x = _mm_loadu_si128((const __m128i*)(col + k * 4));
+            __m128i outside = _mm_or_si128(_mm_cmplt_epi32(x, vlo), _mm_cmpgt_epi32(x, vhi));
+            uint32_t out = (uint32_t)_mm_movemask_ps(_mm_castsi128_ps(outside));
+            bits |= (uint64_t)(~out & 0xfu) << (k * 4);
+        }
+        return bits;
+#else
+        return rangeBitsScalar(col, 64, lo, hi);
+#endif
+    }
+
+    // sel &= (lo <= col[i] <= hi) != negate
+    inline void filterRange(const int32_t* col, Selection& sel, int32_t lo, int32_t hi, bool negate) {
+        size_t full = sel.rows / 64;
+        uint64_t flip = negate ? ~0ull : 0;
+        for (size_t wi = 0; wi < full; wi++) {
+            if (!sel.words[wi]) continue;
+            sel.words[wi] &= rangeBits64(col + wi * 64, lo, hi) ^ flip;
+        }
+        if (sel.rows % 64 && sel.words[full]) {
+            sel.words[full] &= rangeBitsScalar(col + full * 64, sel.rows % 64, lo, hi) ^ flip;
+        }
+    }
+
+    // --- COLUMNAR SNAPSHOT ---
+
+    enum class Field { Id, Name, Company, Stage, Value };
+
+    inline bool parseField(std::string name, Field& out) {
+        for (auto& c : name) c = (char)tolower(c);
+        if (name == "id") out = Field::Id;
+        else if (name == "name") out = Field::Name;
+        else if (name == "company") out = Field::Company;
+        else if (name == "stage" || name == "status") out = Field::Stage;
+        else if (name == "value") out = Field::Value;
+        else return false;
+        return true;
+    }
+
+    class LeadTable {
+    public:
+        std::vector<fluxdb::Id> ids;
+        std::vector<std::string> names;
+        std::vector<int32_t> values;
+        std::vector<int32_t> stages;      // codes into stage_dict
+        std::vector<int32_t> companies;   // codes into company_dict
+        Dictionary stage_dict;
+        Dictionary company_dict;
+
+        size_t size() const { return ids.size(); }
+
+        void load(const std::vector<Lead>& leads) {
+            size_t n = leads.size();
+            ids.resize(n);
+            names.resize(n);
+            values.resize(n);
+
+            std::vector<const std::string*> stage_rows(n), company_rows(n);
+            for (size_t i = 0; i < n; i++) {
+                ids[i] = leads[i].id;
+                names[i] = leads[i].name;
+                values[i] = leads[i].value;
+                stage_rows[i] = &leads[i].status;
+                company_rows[i] = &leads[i].company;
+            }
+            stages = stage_dict.build(stage_rows);
+            companies = company_dict.build(company_rows);
+        }
+
+        Lead row(uint32_t i) const {
+            Lead l;
+            l.id = ids[i];
+            l.name = names[i];
+            l.company = company_dict.str(companies[i]);
+            l.status = stage_dict.str(stages[i]);
+            l.value = values[i];
+            return l;
+        }
+    };
+
+    // --- PREDICATES ---
+
+    struct Predicate {
+        Field field = Field::Value;
+        std::string op;       // = != < <= > >= ~
+        std::string literal;
+    };
+
+    struct OrderBy {
+        bool enabled = false;
+        Field field = Field::Value;
+        bool descending = true;
+    };
+
+    struct QuerySpec {
+        std::vector<Predicate> where;
+        OrderBy order;
+        size_t limit = 0;     // 0 = all
+    };
+
+    struct QueryResult {
+        std::vector<uint32_t> rows;
+        size_t matched = 0;
+        double scan_ms = 0.0;
+    };
+
+    // "stage=Won and value>50000, company=\"Acme Inc\"" -> predicates
+    inline bool parseWhere(const std::string& text, std::vector<Predicate>& out, std::string& error) {
+        size_t i = 0, n = text.size();
+        auto skipSpace = [&]() { while (i < n && isspace((unsigned char)text[i])) i++; };
+
+        while (true) {
+            skipSpace();
+            if (i >= n) return true;
+
+            size_t start = i;
+            while (i < n && (isalnum((unsigned char)text[i]) || text[i] == '_')) i++;
+            std::string word = text.substr(start, i - start);
+            std::string lower = word;
+            for (auto& c : lower) c = (char)tolower(c);
+            if (lower == "and") continue;
+            if (word.empty() && i < n && text[i] == ',') { i++; continue; }
+
+            Predicate p;
+            if (!parseField(word, p.field)) { error = "Unknown field '" + word + "'"; return false; }
+
+            skipSpace();
+            static const char* ops[] = { "<=", ">=", "!=", "==", "=", "<", ">", "~" };
+            bool found = false;
+            for (const char* op : ops) {
+                size_t len = strlen(op);
+                if (text.compare(i, len, op) == 0) { p.op = (std::string(op) == "==") ? "=" : op; i += len; found = true; break; }
+            }
+            if (!found) { error = "Expected operator after '" + word + "'"; return false; }
+
+            skipSpace();
+            if (i < n && (text[i] == '"' || text[i] == '\'')) {
+                char quote = text[i++];
+                size_t end = text.find(quote, i);
+                if (end == std::string::npos) { error = "Unterminated quote"; return false; }
+                p.literal = text.substr(i, end - i);
+                i = end + 1;
+            } else {
+                start = i;
+                while (i < n && !isspace((unsigned char)text[i]) && text[i] != ',') i++;
+                p.literal = text.substr(start, i - start);
+            }
+            if (p.literal.empty()) { error = "Missing value for '" + word + "'"; return false; }
+            out.push_back(p);
+        }
+    }
+
+    // --- EXECUTION ---
+
+    class Engine {
+    private:
+        const LeadTable& table;
+
+        // [lo, hi] over the code space of a dictionary, or empty (lo > hi)
+        static void codeRange(const Dictionary& dict, const Predicate& p, int32_t& lo, int32_t& hi, bool& negate) {
+            int32_t last = (int32_t)dict.size() - 1;
+            lo = 0; hi = last; negate = false;
+            if (p.op == "=" || p.op == "!=") {
+                int32_t c = dict.code(p.literal);
+                if (c < 0) { lo = 0; hi = -1; } // unknown string: matches nothing
+                else lo = hi = c;
+                negate = (p.op == "!=");
+            }
+            else if (p.op == "<")  hi = dict.lowerBound(p.literal) - 1;
+            else if (p.op == "<=") hi = dict.upperBound(p.literal) - 1;
+            else if (p.op == ">")  lo = dict.upperBound(p.literal);
+            else if (p.op == ">=") lo = dict.lowerBound(p.literal);
+        }
+
+        static bool numericRange(const Predicate& p, int32_t& lo, int32_t& hi, bool& negate, std::string& error) {
+            double v;
+            try { v = std::stod(p.literal); } catch (...) { error = "Not a number: " + p.literal; return false; }
+
+            const double MIN = std::numeric_limits<int32_t>::min(), MAX = std::numeric_limits<int32_t>::max();
+            auto clamp = [&](double d) { return (int32_t)std::max(MIN, std::min(MAX, d)); };
+            lo = std::numeric_limits<int32_t>::min();
+            hi = std::numeric_limits<int32_t>::max();
+            negate = false;
+
+            if (p.op == "=" || p.op == "!=") {
+                if (v != std::floor(v)) { lo = 1; hi = 0; } else { lo = hi = clamp(v); }
+                negate = (p.op == "!=");
+            }
+            else if (p.op == "<")  hi = clamp(std::ceil(v) - 1);
+            else if (p.op == "<=") hi = clamp(std::floor(v));
+            else if (p.op == ">")  lo = clamp(std::floor(v) + 1);
+            else if (p.op == ">=") lo = clamp(std::ceil(v));
+            else { error = "Operator " + p.op + " needs a text field"; return false; }
+            return true;
+        }
+
+        // ValueLess order for the column, ties broken by id
+        bool less(Field f, uint32_t a, uint32_t b) const {
+            switch (f) {
+                case Field::Value:
+                    if (table.values[a] != table.values[b]) return table.values[a] < table.values[b];
+                    break;
+                case Field::Stage:
+                    if (table.stages[a] != table.stages[b]) return table.stages[a] < table.stages[b];
+                    break;
+                case Field::Company:
+                    if (table.companies[a] != table.companies[b]) return table.companies[a] < table.companies[b];
+                    break;
+                case Field::Name:
+                    if (table.names[a] != table.names[b]) return table.names[a] < table.names[b];
+                    break;
+                case Field::Id:
+                    break;
+            }
+            return table.ids[a] < table.ids[b];
+        }
+
+    public:
+        explicit Engine(const LeadTable& t) : table(t) {}
+
+        bool run(const QuerySpec& spec, QueryResult& result, std::string& error) const {
+            auto t0 = std::chrono::steady_clock::now();
+            size_t n = table.size();
+            Selection sel(n);
+
+            for (const Predicate& p : spec.where) {
+                int32_t lo, hi;
+                bool negate;
+
+                if (p.op == "~") {
+                    // Substring match: resolved once per dictionary entry for company
+                    if (p.field == Field::Company) {
+                        std::vector<uint8_t> hit(table.company_dict.size());
+                        for (size_t c = 0; c < hit.size(); c++)
+                            hit[c] = table.company_dict.str((int32_t)c).find(p.literal) != std::string::npos;
+                        sel.refine([&](uint32_t r) { return hit[table.companies[r]] != 0; });
+                    } else if (p.field == Field::Name) {
+                        sel.refine([&](uint32_t r) { return table.names[r].find(p.literal) != std::string::npos; });
+                    } else {
+                        error = "~ only applies to name/company";
+                        return false;
+                    }
+                    continue;
+                }
+
+                switch (p.field) {
+                    case Field::Value:
+                        if (!numericRange(p, lo, hi, negate, error)) return false;
+                        filterRange(table.values.data(), sel, lo, hi, negate);
+                        break;
+                    case Field::Stage:
+                        codeRange(table.stage_dict, p, lo, hi, negate);
+                        filterRange(table.stages.data(), sel, lo, hi, negate);
+                        break;
+                    case Field::Company:
+                        codeRange(table.company_dict, p, lo, hi, negate);
+                        filterRange(table.companies.data(), sel, lo, hi, negate);
+                        break;
+                    case Field::Name:
+                        if (p.op != "=" && p.op != "!=") { error = "name supports =, != and ~"; return false; }
+                        sel.refine([&](uint32_t r) { return (table.names[r] == p.literal) != (p.op == "!="); });
+                        break;
+                    case Field::Id: {
+                        fluxdb::Id v;
+                        try { v = std::stoull(p.literal); } catch (...) { error = "Not a number: " + p.literal; return false; }
+                        const std::string& op = p.op;
+                        sel.refine([&](uint32_t r) {
+                            fluxdb::Id id = table.ids[r];
+                            return (op == "=") ? id == v : (op == "!=") ? id != v : (op == "<") ? id < v :
+                                   (op == "<=") ? id <= v : (op == ">") ? id > v : id >= v;
+                        });
+                        break;
+                    }
+                }
+            }
+
+            std::vector<uint32_t>& rows = result.rows;
+            rows.clear();
+            result.matched = sel.count();
+
+            const OrderBy& order = spec.order;
+            auto before = [&](uint32_t a, uint32_t b) {
+                return order.descending ? less(order.field, b, a) : less(order.field, a, b);
+            };
+
+            if (!order.enabled) {
+                size_t want = spec.limit ? std::min(spec.limit, result.matched) : result.matched;
+                rows.reserve(want);
+                for (size_t wi = 0; wi < sel.words.size() && rows.size() < want; wi++) {
+                    for (uint64_t w = sel.words[wi]; w && rows.size() < want; w &= w - 1)
+                        rows.push_back((uint32_t)(wi * 64 + lowestBit(w)));
+                }
+            }
+            else if (spec.limit && spec.limit < result.matched) {
+                // Top-K: max-heap on "before", so the root is the worst row kept
+                std::priority_queue<uint32_t, std::vector<uint32_t>, decltype(before)> heap(before);
+                sel.forEach([&](uint32_t r) {
+                    if (heap.size() < spec.limit) heap.push(r);
+                    else if (before(r, heap.top())) { heap.pop(); heap.push(r); }
+                });
+                rows.resize(heap.size());
+                for (size_t k = rows.size(); k-- > 0;) { rows[k] = heap.top(); heap.pop(); }
+            }
+            else {
+                rows.reserve(result.matched);
+                sel.forEach([&](uint32_t r) { rows.push_back(r); });
+                std::sort(rows.begin(), rows.end(), before);
+            }
+
+            result.scan_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+            return true;
+        }
+    };
+}
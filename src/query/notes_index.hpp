@@ -0,0 +1,237 @@
+#pragma once
+#include "../../vendor/fluxdb/document.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Full-text index over interaction notes, ranked with BM25.
+//
+// Notes are split into lowercase words (runs of letters and digits; bytes of
+// UTF-8 sequences count as letters). Each word keeps a posting list of
+// (note, count) pairs, delta-coded as varints in insertion order, so adding a
+// note only appends. Removed notes are tombstoned and skipped at query time;
+// the postings are rebuilt once tombstones outnumber live notes.
+
+namespace Query {
+
+    struct NoteHit {
+        fluxdb::Id id = 0;
+        fluxdb::Id parent_id = 0;
+        double score = 0.0;             // note text: NotesIndex::text(id)
+    };
+
+    struct NoteSearchResult {
+        std::vector<NoteHit> hits;  // best first
+        size_t matched = 0;         // notes containing at least one query word
+        double search_ms = 0.0;
+    };
+
+    class NotesIndex {
+    private:
+        static constexpr double K1 = 1.2;
+        static constexpr double B = 0.75;
+
+        struct Note {
+            fluxdb::Id id = 0;
+            fluxdb::Id parent_id = 0;
+            uint32_t length = 0;    // words
+            bool live = true;
+            std::string text;
+        };
+
+        struct Postings {
+            std::vector<uint8_t> bytes;  // varint(note - previous note), varint(count)
+            uint32_t last = 0;           // last note appended
+            uint32_t live = 0;           // live notes containing the word (BM25 df)
+        };
+
+        std::vector<Note> notes;                        // indexed by note number
+        std::unordered_map<fluxdb::Id, uint32_t> by_id;
+        std::unordered_map<std::string, Postings> terms;
+        size_t live_notes = 0;
+        uint64_t live_words = 0;
+
+        // Query scratch, reused so searches do not reallocate
+        mutable std::vector<float> scores;
+        mutable std::vector<uint32_t> touched;
+
+        static void putVarint(std::vector<uint8_t>& out, uint32_t v) {
+            while (v >= 0x80) {
+                out.push_back((uint8_t)(v | 0x80));
+                v >>= 7;
+            }
+            out.push_back((uint8_t)v);
+        }
+
+        static uint32_t getVarint(const uint8_t*& p) {
+            uint32_t v = 0;
+            for (int shift = 0;; shift += 7) {
+                uint8_t b = *p++;
+                v |= (uint32_t)(b & 0x7f) << shift;
+                if (!(b & 0x80)) return v;
+            }
+        }
+
+        // Word -> occurrences in one note
+        static void countWords(const std::string& text, std::unordered_map<std::string, uint32_t>& out, uint32_t& length) {
+            out.clear();
+            length = 0;
+            tokenize(text, [&](std::string&& w) {
+                out[std::move(w)]++;
+                length++;
+            });
+        }
+
+        void index(uint32_t n) {
+            std::unordered_map<std::string, uint32_t> counts;
+            Note& note = notes[n];
+            countWords(note.text, counts, note.length);
+            for (auto& [word, count] : counts) {
+                Postings& p = terms[word];
+                putVarint(p.bytes, p.bytes.empty() ? n : n - p.last);
+                putVarint(p.bytes, count);
+                p.last = n;
+                p.live++;
+            }
+            live_notes++;
+            live_words += note.length;
+        }
+
+        void rebuild() {
+            std::vector<Note> old;
+            old.swap(notes);
+            clear();
+            for (Note& n : old)
+                if (n.live) add(n.id, n.parent_id, std::move(n.text));
+        }
+
+    public:
+        // Calls fn(std::string&&) for each word of `text`
+        template <typename Fn>
+        static void tokenize(const std::string& text, Fn&& fn) {
+            std::string word;
+            for (char ch : text) {
+                unsigned char c = (unsigned char)ch;
+                if (c >= 0x80 || isalnum(c)) {
+                    word += (char)tolower(c);
+                } else if (!word.empty()) {
+                    fn(std::move(word));
+                    word.clear();
+                }
+            }
+            if (!word.empty()) fn(std::move(word));
+        }
+
+        size_t size() const { return live_notes; }
+
+        // Text of a live note, or nullptr. Valid until the index changes.
+        const std::string* text(fluxdb::Id id) const {
+            auto it = by_id.find(id);
+            return it == by_id.end() ? nullptr : &notes[it->second].text;
+        }
+        size_t termCount() const { return terms.size(); }
+
+        void clear() {
+            notes.clear();
+            by_id.clear();
+            terms.clear();
+            live_notes = 0;
+            live_words = 0;
+        }
+
+        void add(fluxdb::Id id, fluxdb::Id parent_id, std::string text) {
+            if (by_id.count(id)) remove(id);
+            uint32_t n = (uint32_t)notes.size();
+            notes.push_back({ id, parent_id, 0, true, std::move(text) });
+            by_id[id] = n;
+            index(n);
+        }
+
+        bool remove(fluxdb::Id id) {
+            auto it = by_id.find(id);
+            if (it == by_id.end()) return false;
+
+            Note& note = notes[it->second];
+            std::unordered_map<std::string, uint32_t> counts;
+            uint32_t length = 0;
+            countWords(note.text, counts, length);
+            for (auto& kv : counts) {
+                auto t = terms.find(kv.first);
+                if (t != terms.end() && t->second.live) t->second.live--;
+            }
+            note.live = false;
+            note.text.clear();
+            note.text.shrink_to_fit();
+            live_notes--;
+            live_words -= note.length;
+            by_id.erase(it);
+
+            if (notes.size() > 1024 && notes.size() - live_notes > live_notes) rebuild();
+            return true;
+        }
+
+        // BM25 over the words of `query`; returns the best `limit` live notes
+        NoteSearchResult search(const std::string& query, size_t limit = 20) const {
+            auto t0 = std::chrono::steady_clock::now();
+            NoteSearchResult result;
+
+            std::vector<std::string> words;
+            tokenize(query, [&](std::string&& w) {
+                if (std::find(words.begin(), words.end(), w) == words.end()) words.push_back(std::move(w));
+            });
+
+            if (scores.size() < notes.size()) scores.resize(notes.size(), 0.0f);
+            touched.clear();
+
+            double N = (double)live_notes;
+            double avg_len = live_notes ? (double)live_words / live_notes : 1.0;
+            for (const std::string& w : words) {
+                auto t = terms.find(w);
+                if (t == terms.end() || t->second.live == 0) continue;
+                const Postings& p = t->second;
+                double df = (double)p.live;
+                double idf = std::log(1.0 + (N - df + 0.5) / (df + 0.5));
+
+                const uint8_t* it = p.bytes.data();
+                const uint8_t* end = it + p.bytes.size();
+                uint32_t n = 0;
+                bool first = true;
+                while (it < end) {
+                    n = first ? getVarint(it) : n + getVarint(it);
+                    first = false;
+                    uint32_t tf = getVarint(it);
+                    const Note& note = notes[n];
+                    if (!note.live) continue;
+
+                    double norm = K1 * (1.0 - B + B * note.length / avg_len);
+                    if (scores[n] == 0.0f) touched.push_back(n);
+                    scores[n] += (float)(idf * tf * (K1 + 1.0) / (tf + norm));
+                }
+            }
+
+            result.matched = touched.size();
+            size_t k = limit ? std::min(limit, touched.size()) : touched.size();
+            auto better = [&](uint32_t a, uint32_t b) {
+                if (scores[a] != scores[b]) return scores[a] > scores[b];
+                return notes[a].id > notes[b].id; // newer first on ties
+            };
+            std::partial_sort(touched.begin(), touched.begin() + k, touched.end(), better);
+
+            result.hits.reserve(k);
+            for (size_t i = 0; i < k; i++) {
+                const Note& note = notes[touched[i]];
+                result.hits.push_back({ note.id, note.parent_id, scores[touched[i]] });
+            }
+            for (uint32_t n : touched) scores[n] = 0.0f;
+
+            result.search_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+            return result;
+        }
+    };
+}
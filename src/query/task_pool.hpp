@@ -0,0 +1,154 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Work-stealing thread pool for the local analytics (forecast, dedupe).
+//
+// Every worker owns a deque: it pushes and pops its own tasks at the back
+// (newest, still hot in cache) and steals from the front of the others
+// (oldest, usually the biggest pieces of a split range). parallelFor splits
+// ranges in halves on demand, so idle workers take large chunks and busy
+// ones keep splitting only while someone is hungry for work. The calling
+// thread runs tasks too while it waits, so nested calls never deadlock.
+
+namespace Query {
+
+    class TaskPool {
+    private:
+        struct Queue {
+            std::mutex lock;
+            std::deque<std::function<void()>> tasks;
+        };
+
+        struct Current {
+            const TaskPool* pool = nullptr;
+            size_t index = 0;
+        };
+
+        std::vector<std::unique_ptr<Queue>> queues;  // one per worker
+        std::vector<std::thread> workers;
+        std::atomic<size_t> queued{0};
+        std::atomic<size_t> next_queue{0};
+        std::mutex sleep_lock;
+        std::condition_variable wake;
+        bool stopping = false;
+
+        static Current& current() {
+            static thread_local Current c;
+            return c;
+        }
+
+        // Own queue from the back, then the others from the front
+        bool take(size_t self, std::function<void()>& task) {
+            size_t n = queues.size();
+            for (size_t k = 0; k < n; k++) {
+                Queue& q = *queues[(self + k) % n];
+                std::lock_guard<std::mutex> guard(q.lock);
+                if (q.tasks.empty()) continue;
+                if (k == 0) { task = std::move(q.tasks.back()); q.tasks.pop_back(); }
+                else { task = std::move(q.tasks.front()); q.tasks.pop_front(); }
+                queued.fetch_sub(1, std::memory_order_relaxed);
+                return true;
+            }
+            return false;
+        }
+
+        void workerLoop(size_t self) {
+            current() = { this, self };
+            std::function<void()> task;
+            while (true) {
+                if (take(self, task)) {
+                    task();
+                    task = nullptr;
+                    continue;
+                }
+                std::unique_lock<std::mutex> guard(sleep_lock);
+                wake.wait(guard, [&] { return stopping || queued.load(std::memory_order_relaxed) > 0; });
+                if (stopping && queued.load(std::memory_order_relaxed) == 0) return;
+            }
+        }
+
+        // Runs one queued task on the calling thread; false if there was none
+        bool helpOnce() {
+            if (queues.empty()) return false;
+            const Current& c = current();
+            size_t self = c.pool == this ? c.index : next_queue.load(std::memory_order_relaxed) % queues.size();
+            std::function<void()> task;
+            if (!take(self, task)) return false;
+            task();
+            return true;
+        }
+
+    public:
+        // `threads` counts the caller, which helps while it waits: 1 runs everything inline
+        explicit TaskPool(unsigned threads = 0) {
+            if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+            for (unsigned i = 1; i < threads; i++) queues.push_back(std::make_unique<Queue>());
+            for (size_t i = 0; i < queues.size(); i++) workers.emplace_back([this, i]() { workerLoop(i); });
+        }
+
+        ~TaskPool() {
+            {
+                std::lock_guard<std::mutex> guard(sleep_lock);
+                stopping = true;
+            }
+            wake.notify_all();
+            for (auto& t : workers) t.join();
+        }
+
+        TaskPool(const TaskPool&) = delete;
+        TaskPool& operator=(const TaskPool&) = delete;
+
+        // One pool per process, sized to the machine
+        static TaskPool& shared() {
+            static TaskPool pool;
+            return pool;
+        }
+
+        unsigned threads() const { return (unsigned)workers.size() + 1; }
+
+        void submit(std::function<void()> task) {
+            if (queues.empty()) { task(); return; }
+            const Current& c = current();
+            size_t q = c.pool == this ? c.index : next_queue.fetch_add(1, std::memory_order_relaxed) % queues.size();
+            {
+                std::lock_guard<std::mutex> guard(queues[q]->lock);
+                queues[q]->tasks.push_back(std::move(task));
+            }
+            queued.fetch_add(1, std::memory_order_relaxed);
+            { std::lock_guard<std::mutex> guard(sleep_lock); }
+            wake.notify_one();
+        }
+
+        // Calls fn(begin, end) over disjoint pieces of [0, n), none longer than
+        // `grain`, and returns once all are done. fn must not throw.
+        template <typename Fn>
+        void parallelFor(size_t n, size_t grain, Fn&& fn) {
+            if (n == 0) return;
+            grain = std::max<size_t>(grain, 1);
+            if (queues.empty() || n <= grain) { fn((size_t)0, n); return; }
+
+            std::atomic<size_t> remaining{ n };
+            std::function<void(size_t, size_t)> run = [&](size_t begin, size_t end) {
+                while (end - begin > grain) {
+                    size_t mid = begin + (end - begin) / 2;
+                    submit([&run, mid, end]() { run(mid, end); });
+                    end = mid;
+                }
+                fn(begin, end);
+                remaining.fetch_sub(end - begin, std::memory_order_acq_rel);
+            };
+            run(0, n);
+            while (remaining.load(std::memory_order_acquire) > 0)
+                if (!helpOnce()) std::this_thread::yield();
+        }
+    };
+}
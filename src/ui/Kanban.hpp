@@ -2,6 +2,8 @@
 #include "../crm_core.hpp"
 #include "imgui.h"
 #include <string>
+#include <vector>
+#include <cstdio>
 
 namespace UI {
 
@@ -13,6 +15,10 @@ private:
     int new_lead_value = 1000;
     bool show_error = false;
 
+    // Paged columns, refreshed every couple of seconds
+    std::vector<LeadCursor> columns;
+    double fetched_at = -1.0;
+
 public:
     void Render(CRMSystem& crm, bool is_connected) {
         if (!is_connected) return;
@@ -58,6 +64,7 @@ public:
 
                     if (crm.addLead(l)) {
                         crm.publishEvent("New Lead: " + std::string(new_lead_name));
+                        for (auto& c : columns) c.invalidate();
                         ImGui::CloseCurrentPopup();
                     }
                 }
@@ -69,21 +76,49 @@ public:
 
         ImGui::Separator();
         const char* stages[] = { "New", "Contacted", "Won" };
+        if (columns.empty()) {
+            for (const char* stage : stages) columns.emplace_back(crm, stage);
+        }
+
+        double now = ImGui::GetTime();
+        if (now - fetched_at > 2.0) {
+            fetched_at = now;
+            for (auto& c : columns) c.invalidate();
+        }
+
         ImGui::Columns(3, "kanban_cols");
         
         for (int i = 0; i < 3; i++) {
             ImGui::TextColored(ImVec4(0.4f, 0.8f, 1.0f, 1.0f), "%s", stages[i]);
             ImGui::Separator();
             
-            auto leads = crm.getLeadsByStage(stages[i]);
-            for (const auto& lead : leads) {
-                ImGui::PushID(lead.id);
-                std::string label = lead.name + "\n" + lead.company + "\n$" + std::to_string(lead.value);
-                ImGui::Button(label.c_str(), ImVec2(-FLT_MIN, 80));
-                
-                ImGui::PopID();
-                ImGui::Dummy(ImVec2(0.0f, 5.0f));
+            ImGui::PushID(i);
+            ImGui::BeginChild("cards", ImVec2(0, 0));
+
+            ImGuiListClipper clipper;
+            clipper.Begin((int)columns[i].size());
+            while (clipper.Step()) {
+                columns[i].prefetch(clipper.DisplayStart, clipper.DisplayEnd);
+                for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; row++) {
+                    const Lead* lead = columns[i].at(row);
+                    if (!lead) {
+                        ImGui::Dummy(ImVec2(0.0f, 80.0f));
+                        ImGui::Dummy(ImVec2(0.0f, 5.0f));
+                        continue;
+                    }
+
+                    ImGui::PushID((int)lead->id);
+                    char label[300];
+                    snprintf(label, sizeof(label), "%s\n%s\n$%d", lead->name.c_str(), lead->company.c_str(), lead->value);
+                    ImGui::Button(label, ImVec2(-FLT_MIN, 80));
+                    
+                    ImGui::PopID();
+                    ImGui::Dummy(ImVec2(0.0f, 5.0f));
+                }
             }
+
+            ImGui::EndChild();
+            ImGui::PopID();
             ImGui::NextColumn();
         }
         ImGui::End();
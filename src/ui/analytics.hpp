@@ -3,8 +3,11 @@
 #include "implot.h"
 #include "context.hpp"
 
+#include <algorithm>
+
 namespace UI {
     inline void RenderAnalytics(AppState& state) {
+        FLUX_SPAN("ui.analytics");
         ImGuiCond cond = state.reset_layout ? ImGuiCond_Always : ImGuiCond_FirstUseEver;
 
         ImGui::SetNextWindowPos(ImVec2(UI::SIDEBAR_WIDTH, UI::PIPELINE_HEIGHT), cond); 
@@ -20,8 +23,22 @@ namespace UI {
             ImPlot::SetupAxes("Stage", "Total Value ($)");
             ImPlot::SetupAxisTicks(ImAxis_X1, 0, 2, 3, state.stages);
             
+            // Raw stage value beside the win-probability weighted forecast and its P10-P90 band
+            const Query::ForecastResult& f = state.forecast;
+            double xs[3], below[3], above[3];
+            for (int i = 0; i < 3; i++) {
+                xs[i] = i + 0.2;
+                below[i] = f.expected[i] - std::min(f.low[i], f.expected[i]);
+                above[i] = std::max(f.high[i], f.expected[i]) - f.expected[i];
+            }
+
+            ImPlot::SetNextFillStyle(ImVec4(0.4f, 0.4f, 0.45f, 1.0f));
+            ImPlot::PlotBars("Pipeline Value", state.stage_values, 3, 0.35, -0.2);
+
             ImPlot::SetNextFillStyle(ImVec4(0.2f, 0.7f, 0.2f, 1.0f)); 
-            ImPlot::PlotBars("Revenue Forecast", state.stage_values, 3);
+            ImPlot::PlotBars("Revenue Forecast", f.expected, 3, 0.35, 0.2);
+            ImPlot::SetNextErrorBarStyle(ImVec4(0.9f, 0.9f, 0.9f, 1.0f));
+            ImPlot::PlotErrorBars("Revenue Forecast", xs, f.expected, below, above, 3);
             
             ImPlot::SetNextLineStyle(ImVec4(1,1,0,1), 3.0f);
             ImPlot::PlotLine("Lead Count", state.stage_counts, 3);
@@ -1,5 +1,6 @@
 #pragma once
 #include "../crm_core.hpp" 
+#include "frame_arena.hpp"
 #include <vector>
 #include <string>
 
@@ -11,6 +12,9 @@ namespace UI {
     const float STATUSBAR_HEIGHT = 40.0f; 
     const float ANALYTICS_HEIGHT = 360.0f;
 
+    const double DATA_REFRESH_SECONDS = 2.0;
+    const double FORECAST_RELOAD_SECONDS = 30.0;
+
     struct AppState {
         // Core Systems
         CRMSystem crm;
@@ -31,6 +35,97 @@ namespace UI {
         double stage_values[3] = {0, 0, 0};
         const char* stages[3] = { "New", "Contacted", "Won" };
 
+        // Pipeline columns, paged from the server as they scroll into view
+        LeadCursor columns[3] = { {crm, "New"}, {crm, "Contacted"}, {crm, "Won"} };
+
+        // Tasks/notes of hovered or focused cards, fetched in the background
+        // for the details modal; change events mark them stale
+        LeadDetailsCache details{ crm };
+        uint64_t seen_events = 0;
+        double data_fetched_at = -1.0;
+
+        // Sidebar figures, fetched only when the data is invalidated
+        bool sidebar_stale = true;
+        double won_revenue = 0.0;
+        double goal = 10000.0;
+        std::vector<Task> overdue;
+
+        // Revenue forecast (analytics chart, sidebar goal). Our own edits are
+        // applied incrementally; other clients' edits refetch the snapshot, at
+        // most every FORECAST_RELOAD_SECONDS.
+        Query::ForecastResult forecast;
+        bool forecast_stale = true;
+        bool forecast_reload = false;
+        double forecast_loaded_at = -1.0;
+
+        // Scratch memory for the current frame only (labels, ids, log copies)
+        FrameArena arena;
+
+        // Diagnostics (--alloc-stats): heap allocations made by the last frame
+        bool show_alloc_stats = false;
+        uint64_t frame_allocs = 0;
+
+        void InvalidateData() {
+            for (auto& c : columns) c.invalidate();
+            sidebar_stale = true;
+            forecast_stale = true;
+        }
+
+        void RefreshForecast(double now) {
+            if (!is_connected || !forecast_stale) return;
+            bool reload = forecast_reload && now - forecast_loaded_at > FORECAST_RELOAD_SECONDS;
+            forecast = crm.getForecast(reload);
+            if (reload || forecast_loaded_at < 0) {
+                forecast_loaded_at = now;
+                forecast_reload = false;
+            }
+            forecast_stale = false;
+        }
+
+        // Whether any event since seen_events was published by another client.
+        // Events that were overwritten or cleared before being read count as remote.
+        bool hasRemoteEvents(uint64_t events) {
+            uint64_t read = 0;
+            bool remote = false;
+            auto r = ticker.eventsSince(seen_events, [&](uint64_t seq, std::string_view msg) {
+                if (seq >= events) return; // arrived after `events` was read; next frame
+                read++;
+                if (!crm.isOwnEvent(msg)) remote = true;
+            });
+            return remote || r.missed > 0 || seen_events + read < events;
+        }
+
+        // Call once per frame before rendering. Local edits invalidate directly,
+        // remote edits arrive through the ticker, and a slow timer catches the rest.
+        void BeginFrame(double now) {
+            arena.Reset();
+            uint64_t events = ticker.eventCount();
+            if (events != seen_events || now - data_fetched_at > DATA_REFRESH_SECONDS) {
+                if (events != seen_events) {
+                    // Our own edits are already in the notes index and the
+                    // forecast; only other clients' (or unreadable) events reload them
+                    if (hasRemoteEvents(events)) {
+                        forecast_reload = true;
+                        notes_reload = true;
+                    }
+                    notes_dirty = true;
+                    details.invalidate();
+                }
+                seen_events = events;
+                data_fetched_at = now;
+                InvalidateData();
+            }
+            RefreshForecast(now);
+        }
+
+        // History tab search over all notes; rerun only when the text or the
+        // notes change. Other clients' edits reload the index on the next search.
+        char notes_search[128] = "";
+        std::string notes_query;
+        bool notes_dirty = true;
+        bool notes_reload = false;
+        Query::NoteSearchResult notes_found;    // hits hold note ids, not text
+
         // Modal/Selection State
         bool show_details_modal = false;
         bool show_clear_confirm = false;
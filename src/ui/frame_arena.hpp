@@ -0,0 +1,97 @@
+#pragma once
+#include <cstdarg>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace UI {
+
+    // Bump allocator for data that lives until the end of the frame: card labels,
+    // widget ids, copied log lines. Reset() at the start of each frame.
+    // Memory is only requested from the heap while the arena is still growing;
+    // after that every frame reuses the same block.
+    class FrameArena {
+    private:
+        struct Block {
+            std::unique_ptr<char[]> data;
+            size_t size = 0;
+        };
+
+        std::vector<Block> blocks;
+        size_t current = 0;     // block being bumped
+        size_t offset = 0;
+        size_t used = 0;        // bytes handed out this frame
+        size_t high_water = 0;
+
+        void addBlock(size_t min_size) {
+            size_t size = blocks.empty() ? 64 * 1024 : blocks.back().size * 2;
+            while (size < min_size) size *= 2;
+            blocks.push_back({ std::unique_ptr<char[]>(new char[size]), size });
+        }
+
+    public:
+        void* Allocate(size_t size, size_t align = alignof(std::max_align_t)) {
+            if (blocks.empty()) addBlock(size + align);
+
+            while (true) {
+                Block& b = blocks[current];
+                size_t start = (offset + align - 1) & ~(align - 1);
+                if (start + size <= b.size) {
+                    offset = start + size;
+                    used += size;
+                    return b.data.get() + start;
+                }
+                if (current + 1 == blocks.size()) addBlock(size + align);
+                current++;
+                offset = 0;
+            }
+        }
+
+        // Frees everything at once. If last frame spilled into several blocks,
+        // they are merged into one so the next frames stay in a single block.
+        void Reset() {
+            if (used > high_water) high_water = used;
+            if (blocks.size() > 1) {
+                size_t total = 0;
+                for (const Block& b : blocks) total += b.size;
+                blocks.clear();
+                addBlock(total);
+            }
+            current = 0;
+            offset = 0;
+            used = 0;
+        }
+
+        size_t BytesUsed() const { return used; }
+        size_t HighWater() const { return high_water; }
+
+        // --- STRING HELPERS ---
+
+        const char* Copy(const char* s, size_t len) {
+            char* out = (char*)Allocate(len + 1, 1);
+            memcpy(out, s, len);
+            out[len] = '\0';
+            return out;
+        }
+
+        const char* Copy(const std::string& s) { return Copy(s.data(), s.size()); }
+
+        const char* Format(const char* fmt, ...) {
+            va_list args;
+            va_start(args, fmt);
+            va_list probe;
+            va_copy(probe, args);
+            int len = vsnprintf(nullptr, 0, fmt, probe);
+            va_end(probe);
+
+            if (len < 0) { va_end(args); return ""; }
+            char* out = (char*)Allocate((size_t)len + 1, 1);
+            vsnprintf(out, (size_t)len + 1, fmt, args);
+            va_end(args);
+            return out;
+        }
+    };
+}
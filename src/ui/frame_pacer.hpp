@@ -0,0 +1,112 @@
+#pragma once
+#include "imgui.h"
+#include <atomic>
+#include <functional>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <ctime>
+
+namespace UI {
+
+    // What ImGui was doing at the end of a frame. Anything here means the next
+    // frame may look different even without new input.
+    struct FrameSignals {
+        bool item_active = false;   // dragging a slider, holding a button
+        bool text_input = false;    // caret blink
+        bool mouse_down = false;
+        bool drag_drop = false;
+
+        bool Busy() const { return item_active || text_input || mouse_down || drag_drop; }
+
+        static FrameSignals Capture() {
+            ImGuiIO& io = ImGui::GetIO();
+            FrameSignals s;
+            s.item_active = ImGui::IsAnyItemActive();
+            s.text_input = io.WantTextInput;
+            for (bool down : io.MouseDown) s.mouse_down |= down;
+            s.drag_drop = ImGui::GetDragDropPayload() != nullptr;
+            return s;
+        }
+    };
+
+    // Decides whether the GUI loop should draw a frame or sleep.
+    // Platform-free: time is passed in, waking is delegated to a callback,
+    // so it runs the same under the Win32 host and imgui_impl_null.
+    class FramePacer {
+    private:
+        std::atomic<bool> dirty{true};
+        std::function<void()> waker;
+
+        bool idle_enabled = true;
+        double awake_until = 0.0;       // render at full rate until this time
+        int settle_frames = 0;          // ImGui needs a few frames to settle layout after a change
+        std::vector<double> timers;     // sorted absolute deadlines
+
+    public:
+        // Hover tooltips and popups appear ~0.5s after the last mouse move
+        double grace_seconds = 0.6;
+        int frames_after_change = 3;
+
+        void SetIdleEnabled(bool enabled) { idle_enabled = enabled; }
+        bool IdleEnabled() const { return idle_enabled; }
+
+        // Breaks the host out of its sleep from any thread (e.g. PostMessage)
+        void SetWaker(std::function<void()> fn) { waker = std::move(fn); }
+
+        // Same thread as the loop: input that was just pumped
+        void MarkDirty() { dirty = true; }
+
+        // Any thread: subscription events, background fetches. Interrupts the sleep.
+        void Notify() {
+            dirty = true;
+            if (waker) waker();
+        }
+
+        void ScheduleAt(double deadline) {
+            auto it = std::lower_bound(timers.begin(), timers.end(), deadline);
+            if (it != timers.end() && *it == deadline) return;
+            timers.insert(it, deadline);
+        }
+
+        bool ShouldRender(double now) {
+            if (!idle_enabled) return true;
+            if (dirty) return true;
+            if (settle_frames > 0 || now < awake_until) return true;
+            return !timers.empty() && timers.front() <= now;
+        }
+
+        // How long the host may sleep before the next frame is due
+        double SecondsUntilNextFrame(double now) {
+            if (ShouldRender(now)) return 0.0;
+            if (timers.empty()) return -1.0; // until woken
+            return timers.front() - now;
+        }
+
+        void FrameRendered(double now, const FrameSignals& signals) {
+            if (dirty.exchange(false)) {
+                settle_frames = frames_after_change;
+                awake_until = now + grace_seconds;
+            } else if (settle_frames > 0) {
+                settle_frames--;
+            }
+
+            if (signals.Busy()) awake_until = now + grace_seconds;
+
+            while (!timers.empty() && timers.front() <= now) timers.erase(timers.begin());
+        }
+
+        static double Now() {
+            using namespace std::chrono;
+            return duration<double>(steady_clock::now().time_since_epoch()).count();
+        }
+
+        // Overdue alerts change at local midnight
+        static double SecondsUntilMidnight() {
+            time_t now = time(nullptr);
+            tm local = *localtime(&now);
+            int elapsed = local.tm_hour * 3600 + local.tm_min * 60 + local.tm_sec;
+            return (double)(24 * 3600 - elapsed);
+        }
+    };
+}
@@ -24,6 +24,8 @@ namespace UI {
 
     static char search_query[128] = "";
 
+    const float CARD_HEIGHT = 70.0f;
+
     // --- COMPONENT: ADD LEAD MODAL ---
     static void RenderAddLeadModal(AppState& state) {
         if (ImGui::BeginPopupModal("Add Lead Form", NULL, ImGuiWindowFlags_AlwaysAutoResize)) {
@@ -42,6 +44,7 @@ namespace UI {
                 Lead l; l.name = name; l.company = company; l.value = value;
                 if (state.crm.addLead(l)) {
                     state.crm.publishEvent("New Lead: " + std::string(name));
+                    state.InvalidateData();
                     name[0] = '\0'; company[0] = '\0'; 
                     ImGui::CloseCurrentPopup();
                 }
@@ -59,6 +62,10 @@ namespace UI {
         if (state.show_details_modal) ImGui::OpenPopup("Lead Details");
 
         if (ImGui::BeginPopupModal("Lead Details", &state.show_details_modal, ImGuiWindowFlags_AlwaysAutoResize)) {
+            // From the prefetch cache; never waits on the server
+            fluxdb::Id lead_id = state.selected_lead.id;
+            std::shared_ptr<const LeadDetails> details = state.details.get(lead_id);
+
             ImGui::TextColored(ImVec4(0.4f, 1.0f, 0.4f, 1.0f), "%s", state.selected_lead.name.c_str());
             ImGui::TextDisabled("%s", state.selected_lead.company.c_str());
             ImGui::Separator();
@@ -80,19 +87,22 @@ namespace UI {
                     if (!valid) ImGui::BeginDisabled();
                     
                     if (ImGui::Button("Add Task")) {
-                        if (state.crm.addTask(state.selected_lead.id, new_task, due_date)) {
+                        if (state.crm.addTask(lead_id, new_task, due_date)) {
                             state.crm.publishEvent("New Task: " + std::string(new_task));
+                            state.details.refresh(lead_id);
                             new_task[0] = '\0'; due_date[0] = '\0';
                         }
                     }
                     if (!valid) ImGui::EndDisabled();
 
                     ImGui::Separator();
-                    auto tasks = state.crm.getTasks(state.selected_lead.id);
-                    for (auto& t : tasks) {
+                    if (!details) ImGui::TextDisabled("Loading...");
+                    else for (auto& t : details->tasks) {
                         bool done = t.is_done;
-                        if (ImGui::Checkbox(("##t" + std::to_string(t.id)).c_str(), &done))
+                        if (ImGui::Checkbox(state.arena.Format("##t%llu", (unsigned long long)t.id), &done)) {
                             state.crm.toggleTask(t.id, done);
+                            state.details.refresh(lead_id);
+                        }
                         ImGui::SameLine();
                         ImGui::TextDisabled(done ? "%s" : "%s", t.description.c_str());
                         if(!t.due_date.empty()) {
@@ -113,18 +123,39 @@ namespace UI {
                     if (!has_text) ImGui::BeginDisabled();
 
                     if (ImGui::Button("Log")) {
-                        if (state.crm.addInteraction(state.selected_lead.id, note)) {
+                        if (state.crm.addInteraction(lead_id, note)) {
                              state.crm.publishEvent("Note: " + std::string(note)); 
                              note[0] = '\0';
+                             state.notes_dirty = true;
+                             state.details.refresh(lead_id);
                         }
                     }
                     
                     if (!has_text) ImGui::EndDisabled();
-                    if(ImGui::Button("Clear")) state.crm.clearInteractions(state.selected_lead.id);
+                    if(ImGui::Button("Clear")) {
+                        state.crm.clearInteractions(lead_id);
+                        state.notes_dirty = true;
+                        state.details.refresh(lead_id);
+                    }
 
                     ImGui::Separator();
-                    auto history = state.crm.getInteractions(state.selected_lead.id);
-                    for (auto& h : history) ImGui::BulletText("%s", h.note.c_str());
+                    ImGui::InputTextWithHint("##notes_search", "Search all notes...", state.notes_search, sizeof(state.notes_search));
+                    if (state.notes_search[0]) {
+                        if (state.notes_dirty || state.notes_query != state.notes_search) {
+                            state.notes_query = state.notes_search;
+                            state.notes_found = state.crm.searchNotes(state.notes_query, 20, state.notes_reload);
+                            state.notes_dirty = false;
+                            state.notes_reload = false;
+                        }
+                        ImGui::TextDisabled("%zu matches (%.2f ms)", state.notes_found.matched, state.notes_found.search_ms);
+                        for (const auto& h : state.notes_found.hits)
+                            if (const std::string* text = state.crm.noteText(h.id))
+                                ImGui::BulletText("#%llu  %s", (unsigned long long)h.parent_id, text->c_str());
+                        ImGui::Separator();
+                    }
+
+                    if (!details) ImGui::TextDisabled("Loading...");
+                    else for (auto& h : details->interactions) ImGui::BulletText("%s", h.note.c_str());
                     ImGui::EndTabItem();
                 }
                 ImGui::EndTabBar();
@@ -138,7 +169,7 @@ namespace UI {
 
     // --- MAIN PIPELINE RENDERER ---
     inline void RenderPipeline(AppState& state) {
-        
+        FLUX_SPAN("ui.pipeline");
         ImGuiCond cond = state.reset_layout ? ImGuiCond_Always : ImGuiCond_FirstUseEver;
         float width = ImGui::GetIO().DisplaySize.x - UI::SIDEBAR_WIDTH;
         ImGui::SetNextWindowPos(ImVec2(UI::SIDEBAR_WIDTH, 0), cond);
@@ -184,48 +215,69 @@ namespace UI {
                         fluxdb::Id id = *(const fluxdb::Id*)payload->Data; 
                         state.crm.moveLead(id, state.stages[i]);
                         state.crm.publishEvent("Moved lead to " + std::string(state.stages[i]));
+                        state.InvalidateData();
                     }
                     ImGui::EndDragDropTarget();
                 }
 
-                auto leads = state.crm.getLeadsByStage(state.stages[i]);
-                state.stage_counts[i] = (double)leads.size();
+                LeadCursor& column = state.columns[i];
+                column.setFilter(search_query);
+                const StageSummary& stats = column.stats();
+                state.stage_counts[i] = (double)stats.count;
+                state.stage_values[i] = stats.value;
+
+                // Only the cards inside the scroll window are fetched and built
+                ImGui::PushID(i);
+                ImGui::BeginChild("cards", ImVec2(0, 0));
+
+                ImGuiListClipper clipper;
+                clipper.Begin((int)column.size());
+                while (clipper.Step()) {
+                    column.prefetch(clipper.DisplayStart, clipper.DisplayEnd);
+
+                    for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; row++) {
+                        const Lead* lead = column.at(row);
+                        if (!lead) {
+                            ImGui::Dummy(ImVec2(0, CARD_HEIGHT));
+                            ImGui::Dummy(ImVec2(0, 5));
+                            continue;
+                        }
+
+                        ImGui::PushID((int)lead->id);
+                        
+                        ImGui::PushStyleColor(ImGuiCol_Button, (ImVec4)ImColor::HSV(i * 0.35f, 0.6f, 0.6f));
+                        ImGui::PushStyleColor(ImGuiCol_ButtonHovered, (ImVec4)ImColor::HSV(i * 0.35f, 0.7f, 0.7f));
+                        ImGui::PushStyleColor(ImGuiCol_ButtonActive, (ImVec4)ImColor::HSV(i * 0.35f, 0.8f, 0.8f));
 
-                for (auto& lead : leads) {
-                    state.stage_values[i] += lead.value;
+                        const char* label = state.arena.Format("%s\n%s\n$%d", lead->name.c_str(), lead->company.c_str(), lead->value);
+                        ImGui::Button(label, ImVec2(-FLT_MIN, CARD_HEIGHT));
 
-                    if (search_query[0] && 
-                        lead.name.find(search_query) == std::string::npos && 
-                        lead.company.find(search_query) == std::string::npos) 
-                        continue;
+                        // Likely to be opened next: fetch its details ahead of the click
+                        if (ImGui::IsItemHovered(ImGuiHoveredFlags_DelayShort) || ImGui::IsItemFocused())
+                            state.details.prefetch(lead->id);
 
-                    ImGui::PushID((int)lead.id);
-                    
-                    ImGui::PushStyleColor(ImGuiCol_Button, (ImVec4)ImColor::HSV(i * 0.35f, 0.6f, 0.6f));
-                    ImGui::PushStyleColor(ImGuiCol_ButtonHovered, (ImVec4)ImColor::HSV(i * 0.35f, 0.7f, 0.7f));
-                    ImGui::PushStyleColor(ImGuiCol_ButtonActive, (ImVec4)ImColor::HSV(i * 0.35f, 0.8f, 0.8f));
-
-                    std::string label = lead.name + "\n" + lead.company + "\n$" + std::to_string(lead.value);
-                    ImGui::Button(label.c_str(), ImVec2(-FLT_MIN, 70));
-
-                    // DRAG SOURCE
-                    if (ImGui::BeginDragDropSource()) {
-                        ImGui::SetDragDropPayload("LEAD_MOVE", &lead.id, sizeof(fluxdb::Id));
-                        ImGui::Text("Move %s", lead.name.c_str());
-                        ImGui::EndDragDropSource();
-                    }
+                        // DRAG SOURCE
+                        if (ImGui::BeginDragDropSource()) {
+                            ImGui::SetDragDropPayload("LEAD_MOVE", &lead->id, sizeof(fluxdb::Id));
+                            ImGui::Text("Move %s", lead->name.c_str());
+                            ImGui::EndDragDropSource();
+                        }
 
-                    // CONTEXT MENU
-                    if (ImGui::BeginPopupContextItem()) {
-                         if (ImGui::Selectable("Details")) { state.selected_lead = lead; state.show_details_modal = true; }
-                         if (ImGui::Selectable("Delete")) state.crm.deleteLead(lead.id);
-                         ImGui::EndPopup();
-                    }
+                        // CONTEXT MENU
+                        if (ImGui::BeginPopupContextItem()) {
+                             if (ImGui::Selectable("Details")) { state.selected_lead = *lead; state.show_details_modal = true; }
+                             if (ImGui::Selectable("Delete")) { state.crm.deleteLead(lead->id); state.InvalidateData(); }
+                             ImGui::EndPopup();
+                        }
 
-                    ImGui::PopStyleColor(3); 
-                    ImGui::PopID();
-                    ImGui::Dummy(ImVec2(0, 5));
+                        ImGui::PopStyleColor(3); 
+                        ImGui::PopID();
+                        ImGui::Dummy(ImVec2(0, 5));
+                    }
                 }
+
+                ImGui::EndChild();
+                ImGui::PopID();
             }
             ImGui::EndTable();
         }
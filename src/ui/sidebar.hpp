@@ -5,6 +5,7 @@
 namespace UI {
     
     inline void RenderSidebar(AppState& state) {
+        FLUX_SPAN("ui.sidebar");
         ImGuiIO& io = ImGui::GetIO();
         float height = io.DisplaySize.y - UI::STATUSBAR_HEIGHT;
         ImGui::SetNextWindowPos(ImVec2(0, 0), ImGuiCond_Always);
@@ -23,8 +24,9 @@ namespace UI {
              if(ImGui::Button("Disconnect", ImVec2(-1, 0))) { state.is_connected = false; state.status_msg = "Disconnected"; }
         } else {
              if(ImGui::Button("Connect", ImVec2(-1, 0))) { 
+                 state.details.clear();
                  if (state.crm.connect(state.server_ip, state.server_port, state.password)) {
-                    state.is_connected = true; state.status_msg = "Online"; state.ticker.start(state.server_ip, state.server_port, state.password);
+                    state.is_connected = true; state.notes_dirty = true; state.status_msg = "Online"; state.ticker.start(state.server_ip, state.server_port, state.password);
                  } else { state.status_msg = state.crm.getError(); }
              }
         }
@@ -36,25 +38,41 @@ namespace UI {
             ImGui::Dummy(ImVec2(0, 10));
             ImGui::TextDisabled("PERFORMANCE");
             
-            double currentRevenue = state.crm.getWonRevenue();
-            double goal = state.crm.getPerformanceGoal(); 
+            if (state.sidebar_stale) {
+                // The Won column already counts this stage; a second COUNT would be the same round trip
+                const StageSummary& won = state.columns[2].stats();
+                state.won_revenue = won.value;
+                state.goal = state.crm.getPerformanceGoal();
+                state.overdue = state.crm.getOverdueTasks();
+                state.sidebar_stale = false;
+            }
+
+            double currentRevenue = state.won_revenue;
+            double goal = state.goal;
             float progress = (goal > 0) ? (float)(currentRevenue / goal) : 0.0f;
             if (progress > 1.0f) progress = 1.0f;
 
-            char overlay[64];
-            sprintf(overlay, "$%.0f / $%.0f", currentRevenue, goal);
+            const char* overlay = state.arena.Format("$%.0f / $%.0f", currentRevenue, goal);
 
             if (progress >= 1.0f) ImGui::PushStyleColor(ImGuiCol_PlotHistogram, ImVec4(0,1,0,1));
             ImGui::ProgressBar(progress, ImVec2(-1, 0), overlay);
             if (progress >= 1.0f) ImGui::PopStyleColor();
 
+            // Won revenue plus what the open leads are expected to bring in
+            const Query::ForecastResult& f = state.forecast;
+            float forecast_progress = (goal > 0) ? (float)(f.expected_total / goal) : 0.0f;
+            if (forecast_progress > 1.0f) forecast_progress = 1.0f;
+            ImGui::Dummy(ImVec2(0, 5));
+            ImGui::TextDisabled("FORECAST");
+            ImGui::ProgressBar(forecast_progress, ImVec2(-1, 0), state.arena.Format("$%.0f expected", f.expected_total));
+            ImGui::TextDisabled("80%%: $%.0f - $%.0f", f.low_total, f.high_total);
+
             // 3. ALERTS
             ImGui::Dummy(ImVec2(0, 20));
             ImGui::Separator();
             ImGui::TextDisabled("ALERTS");
             
-            // Fetch Overdue Tasks
-            std::vector<Task> overdue = state.crm.getOverdueTasks();
+            const std::vector<Task>& overdue = state.overdue;
 
             if (!overdue.empty()) {
                 ImGui::PushStyleColor(ImGuiCol_ChildBg, ImVec4(0.3f, 0.1f, 0.1f, 0.5f)); 
@@ -105,6 +123,7 @@ namespace UI {
                 int count = state.crm.clearInteractions(-1); // -1 = All
                 
                 state.ticker.clear();
+                state.notes_dirty = true;
                 
                 state.status_msg = "Wiped " + std::to_string(count) + " logs.";
                 state.show_clear_confirm = false;
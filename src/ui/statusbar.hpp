@@ -4,6 +4,7 @@
 
 namespace UI {
     inline void RenderStatusBar(AppState& state) {
+        FLUX_SPAN("ui.statusbar");
         ImGuiViewport* viewport = ImGui::GetMainViewport();
         
         ImVec2 pos = viewport->WorkPos;
@@ -29,17 +30,25 @@ namespace UI {
                 IM_COL32(100, 100, 100, 255), 1.0f
             );
 
-            std::vector<std::string> logs = state.ticker.getLogs();
+            const char* latest = nullptr;
+            state.ticker.withLatest([&](std::string_view msg) { latest = state.arena.Copy(msg.data(), msg.size()); });
             
-            if (!logs.empty()) {
+            if (latest) {
                 ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(1.0f, 1.0f, 0.0f, 1.0f));
-                ImGui::Text(">> %s", logs.back().c_str());
+                ImGui::Text(">> %s", latest);
                 ImGui::PopStyleColor();
             } else {
                 ImGui::PushStyleColor(ImGuiCol_Text, ImVec4(0.0f, 1.0f, 0.0f, 1.0f));
                 ImGui::Text("System Online. Listening for events...");
                 ImGui::PopStyleColor();
             }
+
+            if (state.show_alloc_stats) {
+                const char* stats = state.arena.Format("allocs/frame %llu | arena %zu KB",
+                    (unsigned long long)state.frame_allocs, state.arena.HighWater() / 1024);
+                ImGui::SameLine(ImGui::GetWindowWidth() - ImGui::CalcTextSize(stats).x - 16.0f);
+                ImGui::TextDisabled("%s", stats);
+            }
         }
         ImGui::End();
         ImGui::PopStyleColor();
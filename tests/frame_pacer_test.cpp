@@ -0,0 +1,174 @@
+#include "../src/ui/context.hpp"
+#include "../src/ui/sidebar.hpp"
+#include "../src/ui/pipeline.hpp"
+#include "../src/ui/analytics.hpp"
+#include "../src/ui/statusbar.hpp"
+#include "../src/ui/frame_pacer.hpp"
+#include "../tools/fluxd_mock/mock_server.hpp"
+
+#include "imgui_impl_null.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+
+// Idle rendering, headless: the real panels on imgui's null backend, driven by
+// the same pacer decisions as the Win32 host's NewFrame() but on a simulated
+// 60 Hz clock. An idle app must stop drawing; input and ticker events must
+// bring it back.
+
+namespace {
+
+    int failures = 0;
+
+#define CHECK(cond)                                                                 \
+    do {                                                                            \
+        if (!(cond)) {                                                              \
+            std::fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+            failures++;                                                             \
+        }                                                                           \
+    } while (0)
+
+    struct App {
+        UI::AppState& state;
+        UI::FramePacer& pacer;
+        double now = 1000.0;    // simulated seconds
+        size_t frames = 0;
+
+        void frame() {
+            ImGui::GetIO().DeltaTime = 1.0f / 60.0f;
+            ImGui_ImplNull_NewFrame();
+            ImGui::NewFrame();
+            state.BeginFrame(now);
+            UI::RenderSidebar(state);
+            if (state.is_connected) {
+                UI::RenderPipeline(state);
+                UI::RenderAnalytics(state);
+                UI::RenderStatusBar(state);
+            }
+            if (state.reset_layout) state.reset_layout = false;
+            ImGui::Render();
+            ImGui_ImplNullRender_RenderDrawData(ImGui::GetDrawData());
+            pacer.FrameRendered(now, UI::FrameSignals::Capture());
+            frames++;
+        }
+
+        // Advances the clock in 60 Hz ticks, drawing only when the pacer says
+        // so. Returns the frames drawn.
+        size_t run(double seconds) {
+            size_t before = frames;
+            for (double end = now + seconds; now < end; now += 1.0 / 60.0)
+                if (pacer.ShouldRender(now)) frame();
+            return frames - before;
+        }
+    };
+
+    // Real time: the ticker delivers on its own thread
+    bool waitFor(const std::atomic<int>& counter, int target) {
+        for (int i = 0; i < 200 && counter.load() < target; i++)
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        return counter.load() >= target;
+    }
+}
+
+int main() {
+    Mock::ServerConfig config;
+    config.port = 0;
+    Mock::MockServer server(config);
+    if (!server.start()) {
+        std::fprintf(stderr, "Could not start the mock server\n");
+        return 1;
+    }
+
+    ImGui::CreateContext();
+    ImPlot::CreateContext();
+    ImGui::GetIO().IniFilename = nullptr;
+    ImGui_ImplNull_Init();
+
+    {
+        UI::AppState state;
+        UI::FramePacer pacer;
+        std::atomic<int> wakes{0};
+        pacer.SetWaker([&wakes]() { wakes++; });
+
+        state.server_port = server.port();
+        CHECK(state.crm.connect(state.server_ip, state.server_port, state.password));
+        state.is_connected = true;
+        for (int i = 0; i < 20; i++) {
+            Lead l;
+            l.name = "Lead " + std::to_string(i);
+            l.company = "Acme";
+            state.crm.addLead(l);
+        }
+        state.ticker.setListener([&pacer]() { pacer.Notify(); });
+        state.ticker.start(state.server_ip, state.server_port, state.password);
+
+        fluxdb::FluxDBClient publisher("127.0.0.1", server.port());
+        publisher.auth("flux_admin");
+
+        // Until the ticker has subscribed, events go nowhere
+        for (int i = 0; i < 200 && publisher.publish("crm_events", "Lead Added: warmup") < 1; i++)
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        CHECK(waitFor(wakes, 1));
+
+        App app{ state, pacer };
+
+        // Startup and the warmup event draw, then settle and stop
+        CHECK(app.run(2.0) > 0);
+        CHECK(app.run(10.0) == 0);
+        CHECK(pacer.SecondsUntilNextFrame(app.now) < 0); // sleeps until woken
+
+        // Input: the host pumps it into ImGui and marks the pacer dirty
+        ImGui::GetIO().AddMousePosEvent(400.0f, 300.0f);
+        pacer.MarkDirty();
+        size_t after_input = app.run(2.0);
+        CHECK(after_input > 0);
+        CHECK(after_input < 60);           // the grace period, not a full-rate burst
+        CHECK(app.run(10.0) == 0);
+
+        // Invalidation: a crm_event from another client wakes the sleeping
+        // loop and the next frame reloads the board
+        int woken = wakes.load();
+        uint64_t commands = server.stats().commands;
+        CHECK(publisher.publish("crm_events", "Lead Updated: Lead 3") == 1);
+        CHECK(waitFor(wakes, woken + 1));
+        CHECK(app.run(1.0 / 60.0) == 1);
+        CHECK(server.stats().commands > commands);
+        app.run(2.0);
+        CHECK(app.run(10.0) == 0);
+
+        // A timer (the midnight rollover) draws once when it comes due
+        pacer.ScheduleAt(app.now + 5.0);
+        size_t around_timer = app.run(10.0);
+        CHECK(around_timer > 0);
+        CHECK(app.run(10.0) == 0);
+
+        // Our own events are already in the notes index; another client's reload it
+        state.notes_reload = false;
+        woken = wakes.load();
+        CHECK(state.crm.publishEvent("Note: ours"));
+        CHECK(waitFor(wakes, woken + 1));
+        state.BeginFrame(app.now);
+        CHECK(!state.notes_reload);
+        woken = wakes.load();
+        CHECK(publisher.publish("crm_events", "Note: theirs") == 1);
+        CHECK(waitFor(wakes, woken + 1));
+        state.BeginFrame(app.now);
+        CHECK(state.notes_reload);
+
+        // With idle mode off every tick draws
+        pacer.SetIdleEnabled(false);
+        CHECK(app.run(1.0) >= 59);
+
+        state.ticker.stop();
+    }
+
+    ImGui_ImplNull_Shutdown();
+    ImPlot::DestroyContext();
+    ImGui::DestroyContext();
+    server.stop();
+
+    if (failures) std::fprintf(stderr, "%d check(s) failed\n", failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,212 @@
+#include "../src/gateway/gateway_host.hpp"
+#include "../tools/fluxd_mock/mock_server.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+// The gateway between real clients and an in-process fluxd_mock: shared
+// reads, pipelined writes, fan-out that a stalled subscriber cannot hold up,
+// and honest replies when upstream dies in the middle of a batch.
+
+namespace {
+
+    int failures = 0;
+
+#define CHECK(cond)                                                                 \
+    do {                                                                            \
+        if (!(cond)) {                                                              \
+            std::fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+            failures++;                                                             \
+        }                                                                           \
+    } while (0)
+
+    template <typename Pred>
+    bool waitUntil(Pred pred, int ms = 10000) {
+        for (int i = 0; i < ms / 10 && !pred(); i++)
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        return pred();
+    }
+
+    fluxdb::Document lead(const std::string& name) {
+        fluxdb::Document doc;
+        doc["type"] = std::make_shared<fluxdb::Value>("lead");
+        doc["name"] = std::make_shared<fluxdb::Value>(name);
+        return doc;
+    }
+
+    // A subscriber that never reads: its socket buffers fill up
+    SOCKET stalledSubscriber(int port) {
+        SOCKET sock = socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons((unsigned short)port);
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (connect(sock, (sockaddr*)&addr, sizeof(addr)) == SOCKET_ERROR) return INVALID_SOCKET;
+        std::string hello = "AUTH flux_admin\nSUBSCRIBE crm_events\n";
+        send(sock, hello.data(), (int)hello.size(), FLUX_SEND_FLAGS);
+        return sock;
+    }
+
+    // Whatever arrives on the socket within `ms`
+    std::string readFor(SOCKET sock, int ms) {
+        std::string got;
+        auto until = std::chrono::steady_clock::now() + std::chrono::milliseconds(ms);
+        while (std::chrono::steady_clock::now() < until) {
+            fd_set fds;
+            FD_ZERO(&fds);
+            FD_SET(sock, &fds);
+            timeval tv{ 0, 10000 };
+            if (select((int)sock + 1, &fds, nullptr, nullptr, &tv) <= 0) continue;
+            char buf[4096];
+            int n = recv(sock, buf, sizeof(buf), 0);
+            if (n <= 0) break;
+            got.append(buf, n);
+        }
+        return got;
+    }
+
+    size_t occurrences(const std::string& text, const std::string& what) {
+        size_t n = 0;
+        for (size_t at = text.find(what); at != std::string::npos; at = text.find(what, at + 1)) n++;
+        return n;
+    }
+
+    uint64_t sessionsOpen(Gateway::GatewayHost& gw) {
+        std::string text = gw.statsText();
+        size_t at = text.find("CLIENTS=");
+        return at == std::string::npos ? 0 : std::strtoull(text.c_str() + at + 8, nullptr, 10);
+    }
+}
+
+int main() {
+    Mock::ServerConfig config;
+    config.port = 0;
+    Mock::MockServer server(config);
+    if (!server.start()) {
+        std::fprintf(stderr, "Could not start the mock server\n");
+        return 1;
+    }
+
+    Gateway::GatewayConfig gc;
+    gc.port = 0;
+    gc.upstream = "127.0.0.1";
+    gc.upstream_port = server.port();
+    Gateway::GatewayHost gw(gc);
+    CHECK(gw.start());
+
+    {
+        fluxdb::FluxDBClient a("127.0.0.1", gw.port());
+        fluxdb::FluxDBClient b("127.0.0.1", gw.port());
+        CHECK(a.auth("flux_admin") && a.use("crm_db"));
+        CHECK(b.auth("flux_admin") && b.use("crm_db"));
+
+        // Index creation: answered locally after the first
+        CHECK(a.createIndex({ "type", "name" }));
+        CHECK(b.createIndex({ "type", "name" }));
+        CHECK(a.listIndexes().size() == 1);
+
+        // Pipelined writes go upstream as one batch
+        uint64_t batches = gw.stats().upstream_batches;
+        std::vector<fluxdb::BatchOp> ops(3);
+        for (size_t i = 0; i < ops.size(); i++) {
+            ops[i].kind = fluxdb::BatchOp::Kind::Insert;
+            ops[i].doc = lead("Lead " + std::to_string(i));
+        }
+        auto results = a.pipeline(ops);
+        CHECK(results.size() == 3 && results[0].ok && results[1].ok && results[2].ok);
+        CHECK(gw.stats().upstream_batches == batches + 1);
+
+        // Identical reads: one upstream, the rest from the cache
+        fluxdb::Document q;
+        q["type"] = std::make_shared<fluxdb::Value>("lead");
+        uint64_t reads = gw.stats().upstream_reads;
+        CHECK(a.find(q).size() == 3);
+        CHECK(b.find(q).size() == 3);
+        CHECK(gw.stats().upstream_reads == reads + 1);
+        CHECK(gw.stats().cache_hits >= 1);
+
+        // An inserted id is the one FIND reports and UPDATE accepts, from any
+        // client, including a sharded client that brings its own key
+        fluxdb::ShardedClient sharded({ { "127.0.0.1", gw.port() } });
+        CHECK(sharded.auth("flux_admin") && sharded.use("crm_db"));
+        for (int via = 0; via < 2; via++) {
+            std::string name = "Round trip " + std::to_string(via);
+            fluxdb::Id id = via == 0 ? a.insert(lead(name)) : sharded.insert(lead(name));
+            CHECK(id != 0);
+            fluxdb::Document byName;
+            byName["name"] = std::make_shared<fluxdb::Value>(name);
+            auto found = b.find(byName);
+            CHECK(found.size() == 1 && found[0].count("_id") && (fluxdb::Id)found[0]["_id"]->asInt() == id);
+            fluxdb::Document patch;
+            patch["status"] = std::make_shared<fluxdb::Value>("Qualified");
+            CHECK(b.update(id, patch));
+            fluxdb::ShardedClient other({ { "127.0.0.1", gw.port() } });
+            CHECK(other.auth("flux_admin") && other.use("crm_db"));
+            CHECK(other.update(id, patch));
+            CHECK(other.remove(id));
+        }
+
+        // Fan-out: a subscriber that stops reading is dropped once it falls
+        // too far behind, and never delays the one that keeps up
+        std::atomic<int> received{0};
+        std::atomic<bool> warm{false};
+        std::atomic<bool> in_order{true};
+        fluxdb::FluxDBClient listener("127.0.0.1", gw.port());
+        CHECK(listener.auth("flux_admin"));
+        std::thread listening([&]() {
+            listener.subscribe("crm_events", [&](const std::string& msg) {
+                if (msg.compare(0, 3, "-1 ") == 0) { warm = true; return; }
+                if (msg.compare(0, msg.find(' '), std::to_string(received.load())) != 0) in_order = false;
+                received++;
+            });
+        });
+        SOCKET stalled = stalledSubscriber(gw.port());
+        CHECK(stalled != INVALID_SOCKET);
+        // Until the upstream subscription is up, events go nowhere
+        CHECK(waitUntil([&]() { return b.publish("crm_events", "-1 warmup") >= 1 && (waitUntil([&]() { return warm.load(); }, 100)); }));
+
+        uint64_t open_before = sessionsOpen(gw);
+        const int MESSAGES = 4000;
+        std::string payload(8192, 'x');
+        for (int i = 0; i < MESSAGES; i++) b.publish("crm_events", std::to_string(i) + " " + payload);
+        CHECK(waitUntil([&]() { return received.load() == MESSAGES; }));
+        CHECK(in_order);
+        CHECK(waitUntil([&]() { return sessionsOpen(gw) == open_before - 1; }));
+
+        listener.interrupt();
+        listening.join();
+        closesocket(stalled);
+
+        // Subscribing twice still delivers each message once
+        SOCKET twice = stalledSubscriber(gw.port());
+        CHECK(twice != INVALID_SOCKET);
+        std::string again = "SUBSCRIBE crm_events\n";
+        send(twice, again.data(), (int)again.size(), FLUX_SEND_FLAGS);
+        CHECK(waitUntil([&]() { b.publish("crm_events", "-1 ping"); return readFor(twice, 100).find("-1 ping") != std::string::npos; }));
+        b.publish("crm_events", "-1 once");
+        CHECK(occurrences(readFor(twice, 300), "-1 once") == 1);
+        closesocket(twice);
+
+        // Upstream dies under an open connection: the batch may or may not
+        // have been applied, and the reply says so. Once the pool has dropped
+        // its connections, writes fail up front.
+        server.stop();
+        const std::string insert = "INSERT {\"type\":\"lead\",\"name\":\"late\"}";
+        CHECK(a.rawCommand(insert) == "ERR UNKNOWN_OUTCOME");
+        bool unavailable = false;
+        for (size_t i = 0; i <= gc.pool_size && !unavailable; i++) {
+            std::string reply = a.rawCommand(insert);
+            CHECK(reply == "ERR UNKNOWN_OUTCOME" || reply == "ERR UPSTREAM_UNAVAILABLE");
+            unavailable = reply == "ERR UPSTREAM_UNAVAILABLE";
+        }
+        CHECK(unavailable);
+    }
+
+    gw.stop();
+    if (failures) std::fprintf(stderr, "%d check(s) failed\n", failures);
+    return failures ? 1 : 0;
+}
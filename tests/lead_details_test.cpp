@@ -0,0 +1,81 @@
+#include "../src/crm_core.hpp"
+#include "../tools/fluxd_mock/mock_server.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <thread>
+
+// The details modal's background cache against an in-process fluxd_mock: a
+// fetch that fails (not connected, server gone) must not be cached as a lead
+// with no tasks or notes, and the next request must try again.
+
+namespace {
+
+    int failures = 0;
+
+#define CHECK(cond)                                                                 \
+    do {                                                                            \
+        if (!(cond)) {                                                              \
+            std::fprintf(stderr, "%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #cond); \
+            failures++;                                                             \
+        }                                                                           \
+    } while (0)
+
+    template <typename Pred>
+    bool waitUntil(Pred pred, int ms = 5000) {
+        for (int i = 0; i < ms / 10 && !pred(); i++)
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        return pred();
+    }
+
+    const fluxdb::Id LEAD = 42;
+}
+
+int main() {
+    Mock::ServerConfig config;
+    config.port = 0;
+    Mock::MockServer server(config);
+    if (!server.start()) {
+        std::fprintf(stderr, "Could not start the mock server\n");
+        return 1;
+    }
+
+    {
+        CRMSystem crm;
+        LeadDetailsCache details(crm);
+        std::atomic<int> ready{0};
+        details.setListener([&ready]() { ready++; });
+
+        // Not connected: nothing to show, nothing cached
+        LeadDetails fetched;
+        CHECK(!crm.getDetails(LEAD, fetched));
+        CHECK(details.get(LEAD) == nullptr);
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        CHECK(details.get(LEAD) == nullptr);
+        CHECK(ready == 0);
+
+        // Connected: the next request fetches again and succeeds
+        details.clear();
+        CHECK(crm.connect("127.0.0.1", server.port(), "flux_admin"));
+        CHECK(crm.addTask(LEAD, "Call back", ""));
+        CHECK(crm.addInteraction(LEAD, "Asked for a quote"));
+        CHECK(waitUntil([&]() { return details.get(LEAD) != nullptr; }));
+        auto shown = details.get(LEAD);
+        CHECK(shown && shown->tasks.size() == 1 && shown->interactions.size() == 1);
+
+        // Server gone: the refetch fails and the last good details stay
+        server.stop();
+        CHECK(!crm.getDetails(LEAD, fetched));
+        int before = ready.load();
+        details.invalidate();
+        details.get(LEAD);
+        std::this_thread::sleep_for(std::chrono::milliseconds(200));
+        shown = details.get(LEAD);
+        CHECK(shown && shown->tasks.size() == 1 && shown->interactions.size() == 1);
+        CHECK(ready == before);
+    }
+
+    if (failures) std::fprintf(stderr, "%d check(s) failed\n", failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,193 @@
+#include "../../vendor/fluxdb/fluxdb_client.hpp"
+#include "../../vendor/fluxdb/trace.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// flux_replay: re-issues a recorded workload trace (flux_crm --trace) against a server.
+//
+//   flux_replay session.trace --port 8080 --speed 1      recorded pacing
+//   flux_replay session.trace --speed 10 --concurrency 8 10x faster on 8 connections
+//   flux_replay session.trace --speed max                back to back
+//
+// Commands are dealt to the workers round-robin in recorded order, so even a
+// single-connection session spreads over --concurrency connections. Each
+// worker authenticates once and switches database (USE, not timed) whenever
+// its next command came from a recorded connection on another one. AUTH and
+// USE records themselves are not replayed; SUBSCRIBE is skipped since it never
+// returns.
+
+namespace {
+
+    struct Options {
+        std::string trace;
+        std::string host = "127.0.0.1";
+        int port = 8080;
+        std::string password = "flux_admin";
+        double speed = 1.0;          // 0 = as fast as possible
+        int concurrency = 1;
+        int repeat = 1;
+    };
+
+    struct WorkerResult {
+        std::vector<uint64_t> latencies_us;
+        uint64_t bytes = 0;
+        uint64_t errors = 0;
+    };
+
+    void usage() {
+        std::cout <<
+            "Usage: flux_replay <file.trace> [options]\n"
+            "  --host <ip>            server address (default 127.0.0.1)\n"
+            "  --port <n>             server port (default 8080)\n"
+            "  --password <pass>      sent in place of the redacted AUTH\n"
+            "  --speed <1|N|max>      pacing relative to the recording\n"
+            "  --concurrency <n>      client connections (default 1)\n"
+            "  --repeat <n>           replay the trace n times\n";
+    }
+
+    // One command for a worker, and the database it ran against
+    struct WorkItem {
+        const fluxdb::TraceRecord* rec = nullptr;
+        const std::string* db = nullptr;
+    };
+
+    void runWorker(const Options& opt, const std::vector<WorkItem>& work,
+                   std::chrono::steady_clock::time_point start, WorkerResult& out) {
+        using clock = std::chrono::steady_clock;
+        out.latencies_us.reserve(work.size());
+        std::string db = "default";
+        size_t done = 0;
+
+        try {
+            // Traces hold text commands, so replay them on the text protocol as recorded
+            fluxdb::FluxDBClient client(opt.host, opt.port, fluxdb::FluxDBClient::Protocol::Text);
+            client.rawCommand("AUTH " + opt.password);
+
+            for (const WorkItem& item : work) {
+                if (*item.db != db) {
+                    client.rawCommand("USE " + *item.db);
+                    db = *item.db;
+                }
+                if (opt.speed > 0) {
+                    auto due = start + std::chrono::microseconds((int64_t)(item.rec->start_us / opt.speed));
+                    std::this_thread::sleep_until(due);
+                }
+
+                auto t0 = clock::now();
+                std::string resp = client.rawCommand(item.rec->command);
+                out.latencies_us.push_back((uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(clock::now() - t0).count());
+                out.bytes += resp.size();
+                if (resp.compare(0, 3, "ERR") == 0) out.errors++;
+                done++;
+            }
+        } catch (...) {
+            // The connection is gone; the rest of this worker's queue fails with it
+            out.errors += work.size() - done;
+        }
+    }
+
+    uint64_t percentile(const std::vector<uint64_t>& sorted, double p) {
+        if (sorted.empty()) return 0;
+        size_t idx = (size_t)(p / 100.0 * (sorted.size() - 1) + 0.5);
+        return sorted[std::min(idx, sorted.size() - 1)];
+    }
+}
+
+int main(int argc, char** argv) {
+    Options opt;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--help" || arg == "-h") { usage(); return 0; }
+        if (arg.compare(0, 2, "--") != 0) { opt.trace = arg; continue; }
+        if (i + 1 >= argc) { usage(); return 1; }
+
+        std::string val = argv[++i];
+        if (arg == "--host") opt.host = val;
+        else if (arg == "--port") opt.port = std::atoi(val.c_str());
+        else if (arg == "--password") opt.password = val;
+        else if (arg == "--speed") opt.speed = (val == "max") ? 0.0 : std::atof(val.c_str());
+        else if (arg == "--concurrency") opt.concurrency = std::max(1, std::atoi(val.c_str()));
+        else if (arg == "--repeat") opt.repeat = std::max(1, std::atoi(val.c_str()));
+        else { usage(); return 1; }
+    }
+    if (opt.trace.empty()) { usage(); return 1; }
+
+    fluxdb::TraceReader reader(opt.trace);
+    if (!reader.isValid()) {
+        std::cerr << "[replay] Not a trace file: " << opt.trace << "\n";
+        return 1;
+    }
+
+    // Session commands become per-worker setup; the database each recorded
+    // connection was on goes with its commands
+    std::vector<fluxdb::TraceRecord> records;
+    std::vector<std::string> record_db;
+    std::unordered_map<uint64_t, std::string> conn_db;
+    fluxdb::TraceRecord rec;
+    uint64_t recorded_bytes = 0, recorded_us = 0;
+    while (reader.next(rec)) {
+        if (rec.command.compare(0, 10, "SUBSCRIBE ") == 0 || rec.command.compare(0, 4, "AUTH") == 0) continue;
+        if (rec.command.compare(0, 4, "USE ") == 0) {
+            conn_db[rec.conn] = rec.command.substr(4);
+            continue;
+        }
+        auto db = conn_db.find(rec.conn);
+        record_db.push_back(db != conn_db.end() ? db->second : "default");
+        recorded_bytes += rec.response_bytes;
+        recorded_us += rec.latency_us;
+        records.push_back(rec);
+    }
+    if (records.empty()) {
+        std::cerr << "[replay] Trace has no replayable commands.\n";
+        return 1;
+    }
+
+    // Repeats are laid end to end on the recorded timeline
+    int64_t span = records.back().start_us - records.front().start_us + 1;
+    std::vector<std::vector<WorkItem>> queues(opt.concurrency);
+    std::vector<fluxdb::TraceRecord> timeline;
+    timeline.reserve(records.size() * opt.repeat);
+    for (int r = 0; r < opt.repeat; r++) {
+        for (const auto& base : records) {
+            timeline.push_back(base);
+            timeline.back().start_us = base.start_us - records.front().start_us + r * span;
+        }
+    }
+    for (size_t i = 0; i < timeline.size(); i++)
+        queues[i % opt.concurrency].push_back({ &timeline[i], &record_db[i % records.size()] });
+
+    std::vector<WorkerResult> results(opt.concurrency);
+    std::vector<std::thread> workers;
+    auto start = std::chrono::steady_clock::now();
+    for (int w = 0; w < opt.concurrency; w++) {
+        workers.emplace_back(runWorker, std::cref(opt), std::cref(queues[w]), start, std::ref(results[w]));
+    }
+    for (auto& t : workers) t.join();
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    std::vector<uint64_t> all;
+    uint64_t bytes = 0, errors = 0;
+    for (const auto& r : results) {
+        all.insert(all.end(), r.latencies_us.begin(), r.latencies_us.end());
+        bytes += r.bytes;
+        errors += r.errors;
+    }
+    std::sort(all.begin(), all.end());
+
+    std::cout << "[replay] " << all.size() << "/" << timeline.size() << " commands in " << elapsed << " s ("
+              << (elapsed > 0 ? all.size() / elapsed : 0) << " ops/s), " << errors << " errors\n";
+    std::cout << "[replay] latency us: p50=" << percentile(all, 50) << " p90=" << percentile(all, 90)
+              << " p99=" << percentile(all, 99) << " p99.9=" << percentile(all, 99.9)
+              << " max=" << (all.empty() ? 0 : all.back()) << "\n";
+    std::cout << "[replay] response bytes: " << bytes << " replayed vs " << recorded_bytes * opt.repeat
+              << " recorded; recorded mean latency " << recorded_us / records.size() << " us\n";
+    return errors ? 1 : 0;
+}
@@ -0,0 +1,77 @@
+#include "mock_server.hpp"
+
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+#include <string>
+
+// fluxd_mock: local stand-in for fluxd, for benchmarks and fault testing.
+//
+//   fluxd_mock --port 8080 --latency-ms 2 --latency FIND=20 --split 7 --drop-rate 0.01
+
+static std::atomic<bool> g_stop{false};
+
+static void onSignal(int) { g_stop = true; }
+
+static void usage() {
+    std::cout <<
+        "Usage: fluxd_mock [options]\n"
+        "  --port <n>             listen port (default 8080, 0 = any)\n"
+        "  --password <pass>      required AUTH password ('' disables auth)\n"
+        "  --latency-ms <n>       network delay: reply no sooner than n ms after its command arrived\n"
+        "  --latency <CMD>=<ms>   server time for one command, paid serially; repeatable\n"
+        "  --bandwidth <bytes/s>  per-connection write cap\n"
+        "  --split <bytes>        send replies in chunks of this size\n"
+        "  --split-delay-us <n>   pause between chunks\n"
+        "  --drop-rate <p>        chance [0..1] to hang up instead of replying\n"
+        "  --seed <n>             RNG seed for drops\n"
+        "  --text-only            refuse the binary protocol (HELLO), like an older fluxd\n"
+        "  --verbose              log every command\n";
+}
+
+int main(int argc, char** argv) {
+    Mock::ServerConfig config;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+
+        if (arg == "--verbose") config.verbose = true;
+        else if (arg == "--text-only") config.binary = false;
+        else if (arg == "--help" || arg == "-h") { usage(); return 0; }
+        else if (!has_value) { usage(); return 1; }
+        else if (arg == "--port") config.port = std::atoi(argv[++i]);
+        else if (arg == "--password") config.password = argv[++i];
+        else if (arg == "--latency-ms") config.faults.latency_ms = std::atoi(argv[++i]);
+        else if (arg == "--latency") {
+            std::string spec = argv[++i];
+            size_t eq = spec.find('=');
+            if (eq == std::string::npos) { usage(); return 1; }
+            config.faults.command_latency_ms[spec.substr(0, eq)] = std::atoi(spec.c_str() + eq + 1);
+        }
+        else if (arg == "--bandwidth") config.faults.bandwidth_bps = std::strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--split") config.faults.split_bytes = std::strtoull(argv[++i], nullptr, 10);
+        else if (arg == "--split-delay-us") config.faults.split_delay_us = std::atoi(argv[++i]);
+        else if (arg == "--drop-rate") config.faults.drop_rate = std::atof(argv[++i]);
+        else if (arg == "--seed") config.faults.seed = std::strtoull(argv[++i], nullptr, 10);
+        else { usage(); return 1; }
+    }
+
+    Mock::MockServer server(config);
+    if (!server.start()) {
+        std::cerr << "[mock] Could not listen on port " << config.port << "\n";
+        return 1;
+    }
+    std::cout << "[mock] Listening on 127.0.0.1:" << server.port() << "\n";
+
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+    while (!g_stop) std::this_thread::sleep_for(std::chrono::milliseconds(100));
+
+    server.stop();
+    const Mock::ServerStats& st = server.stats();
+    std::cout << "[mock] connections=" << st.connections << " binary=" << st.binary_sessions << " commands=" << st.commands
+              << " bytes_in=" << st.bytes_in << " bytes_out=" << st.bytes_out
+              << " dropped=" << st.dropped << " index_scans=" << st.index_scans << " full_scans=" << st.full_scans << "\n";
+    return 0;
+}
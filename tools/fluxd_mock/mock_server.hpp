@@ -0,0 +1,854 @@
+#pragma once
+#include "../../vendor/fluxdb/socket_compat.hpp"
+#include "../../vendor/fluxdb/document.hpp"
+#include "../../vendor/fluxdb/query_parser.hpp"
+#include "../../vendor/fluxdb/wire_codec.hpp"
+
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <unordered_map>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <shared_mutex>
+#include <thread>
+#include <atomic>
+#include <random>
+#include <chrono>
+#include <sstream>
+#include <iostream>
+#include <algorithm>
+
+// In-memory stand-in for fluxd. Speaks the same line protocol as the real server
+// (plus the COUNT / SKIP / LIMIT / INDEX extensions and the $gt / $contains
+// query operators the CRM uses) and the negotiated binary protocol
+// (wire_codec.hpp), and can inject latency, bandwidth caps, split writes and
+// dropped connections.
+
+namespace Mock {
+
+    struct FaultConfig {
+        int latency_ms = 0;                                 // every command
+        std::map<std::string, int> command_latency_ms;      // e.g. FIND=20, added on top
+        size_t bandwidth_bps = 0;                           // per connection, 0 = unlimited
+        size_t split_bytes = 0;                             // write replies in chunks of this size
+        int split_delay_us = 0;                             // pause between split chunks
+        double drop_rate = 0.0;                             // chance to hang up instead of replying
+        uint64_t seed = 1;
+    };
+
+    struct ServerConfig {
+        int port = 8080;                   // 0 = pick a free port
+        std::string password = "flux_admin";
+        FaultConfig faults;
+        bool binary = true;                // accept HELLO and switch to frames
+        bool verbose = false;
+    };
+
+    struct ServerStats {
+        std::atomic<uint64_t> connections{0};
+        std::atomic<uint64_t> binary_sessions{0};
+        std::atomic<uint64_t> commands{0};
+        std::atomic<uint64_t> bytes_in{0};
+        std::atomic<uint64_t> bytes_out{0};
+        std::atomic<uint64_t> dropped{0};
+        std::atomic<uint64_t> index_scans{0};   // FIND/COUNT served from an index
+        std::atomic<uint64_t> full_scans{0};    // FIND/COUNT that read every document
+    };
+
+    class MockServer {
+    private:
+        using IndexKey = std::vector<fluxdb::Value>;
+
+        struct KeyLess {
+            bool operator()(const IndexKey& a, const IndexKey& b) const {
+                return std::lexicographical_compare(a.begin(), a.end(), b.begin(), b.end(), fluxdb::ValueLess());
+            }
+        };
+
+        // Equality index over one or more fields, ordered so a query on a
+        // leading subset of the fields can use it too
+        struct Index {
+            std::vector<std::string> fields;
+            std::map<IndexKey, std::set<fluxdb::Id>, KeyLess> entries;
+        };
+
+        struct Collection {
+            std::shared_mutex lock;
+            std::map<fluxdb::Id, fluxdb::Document> docs; // id order keeps SKIP/LIMIT stable
+            std::vector<Index> indexes;                  // creation order
+            fluxdb::Id next_id = 1;
+        };
+
+        struct Session {
+            SOCKET sock = INVALID_SOCKET;
+            std::mutex write_lock;
+            std::string db = "default";
+            bool authed = false;
+            std::atomic<bool> binary{false};
+            fluxdb::wire::KeyDecoder keys_in;   // binary only; touched by the session thread
+            fluxdb::wire::KeyEncoder keys_out;
+            std::mt19937_64 rng;
+        };
+
+        ServerConfig config;
+        ServerStats counters;
+        SOCKET listener = INVALID_SOCKET;
+        int bound_port = 0;
+        std::atomic<bool> running{false};
+        std::thread acceptor;
+
+        std::mutex sessions_lock;
+        std::condition_variable sessions_done;
+        std::vector<std::shared_ptr<Session>> sessions; // one detached worker each
+        uint64_t session_seq = 0;
+
+        std::mutex dbs_lock;
+        std::unordered_map<std::string, std::unique_ptr<Collection>> dbs;
+
+        std::mutex channels_lock;
+        std::unordered_map<std::string, std::vector<std::shared_ptr<Session>>> channels;
+
+        Collection& collection(const std::string& name) {
+            std::lock_guard<std::mutex> lk(dbs_lock);
+            auto& slot = dbs[name];
+            if (!slot) slot = std::make_unique<Collection>();
+            return *slot;
+        }
+
+        // --- PROTOCOL HELPERS ---
+
+        // Splits "<json> tail" at the end of the leading JSON object
+        static bool splitJson(const std::string& text, std::string& json, std::string& tail) {
+            size_t start = text.find('{');
+            if (start == std::string::npos) return false;
+
+            int depth = 0;
+            bool in_string = false;
+            for (size_t i = start; i < text.size(); i++) {
+                char c = text[i];
+                if (in_string) {
+                    if (c == '\\') i++;
+                    else if (c == '"') in_string = false;
+                    continue;
+                }
+                if (c == '"') in_string = true;
+                else if (c == '{') depth++;
+                else if (c == '}' && --depth == 0) {
+                    json = text.substr(start, i - start + 1);
+                    tail = text.substr(i + 1);
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        // Query fields are equalities, except two operators:
+        //   "field": {"$gt": x}        greater than x; "_id" compares the row id
+        //   "$contains": {"fields": ["name", ...], "text": "..."}
+        //                              substring of any of those string fields
+        static bool matches(fluxdb::Id id, const fluxdb::Document& doc, const fluxdb::Document& query) {
+            for (const auto& [key, want] : query) {
+                if (key == "$contains") {
+                    if (!containsText(doc, *want)) return false;
+                    continue;
+                }
+                if (want->type == fluxdb::Type::Object && want->asObject().count("$gt")) {
+                    const fluxdb::Value& bound = *want->asObject().at("$gt");
+                    if (key == "_id") {
+                        if (!fluxdb::ValueLess()(bound, fluxdb::Value((int64_t)id))) return false;
+                        continue;
+                    }
+                    auto it = doc.find(key);
+                    if (it == doc.end() || !fluxdb::ValueLess()(bound, *it->second)) return false;
+                    continue;
+                }
+                auto it = doc.find(key);
+                if (it == doc.end() || !(*it->second == *want)) return false;
+            }
+            return true;
+        }
+
+        static bool containsText(const fluxdb::Document& doc, const fluxdb::Value& spec) {
+            if (spec.type != fluxdb::Type::Object) return false;
+            const fluxdb::Document& opts = spec.asObject();
+            auto fields = opts.find("fields"), text = opts.find("text");
+            if (fields == opts.end() || text == opts.end() || text->second->type != fluxdb::Type::String) return false;
+            if (fields->second->type != fluxdb::Type::Array) return false;
+
+            const std::string& needle = text->second->asString();
+            for (const auto& field : std::get<fluxdb::Array>(fields->second->data)) {
+                if (field->type != fluxdb::Type::String) continue;
+                auto it = doc.find(field->asString());
+                if (it != doc.end() && it->second->type == fluxdb::Type::String &&
+                    it->second->asString().find(needle) != std::string::npos) return true;
+            }
+            return false;
+        }
+
+        // Lower bound of an "_id": {"$gt": n} query, so keyed pages start
+        // where the last one ended instead of rescanning from the top
+        static fluxdb::Id idAfter(const fluxdb::Document& query) {
+            auto it = query.find("_id");
+            if (it == query.end() || it->second->type != fluxdb::Type::Object) return 0;
+            auto gt = it->second->asObject().find("$gt");
+            if (gt == it->second->asObject().end() || gt->second->type != fluxdb::Type::Int) return 0;
+            int64_t n = gt->second->asInt();
+            return n > 0 ? (fluxdb::Id)n : 0;
+        }
+
+        // --- INDEXES ---
+
+        // A missing field gets a key no query value can equal (queries are
+        // rechecked against the document anyway)
+        static IndexKey indexKey(const Index& index, const fluxdb::Document& doc) {
+            IndexKey key;
+            key.reserve(index.fields.size());
+            for (const auto& field : index.fields) {
+                auto it = doc.find(field);
+                key.push_back(it != doc.end() ? *it->second : fluxdb::Value(fluxdb::Array{}));
+            }
+            return key;
+        }
+
+        static void unindex(Index& index, const IndexKey& key, fluxdb::Id id) {
+            auto it = index.entries.find(key);
+            if (it == index.entries.end()) return;
+            it->second.erase(id);
+            if (it->second.empty()) index.entries.erase(it);
+        }
+
+        static bool samePrefix(const IndexKey& key, const IndexKey& prefix) {
+            fluxdb::ValueLess less;
+            for (size_t i = 0; i < prefix.size(); i++)
+                if (less(key[i], prefix[i]) || less(prefix[i], key[i])) return false;
+            return true;
+        }
+
+        static bool isEquality(const fluxdb::Document& query, const std::string& field) {
+            auto it = query.find(field);
+            return it != query.end() && it->second->type != fluxdb::Type::Object;
+        }
+
+        // Calls visit(id, doc) for every document that may match `query`, in
+        // id order, until it returns false. Uses the index covering the most
+        // leading query fields, or reads the whole collection. Caller holds
+        // the collection lock.
+        template <typename Visit>
+        void candidates(const Collection& c, const fluxdb::Document& query, Visit visit) {
+            const Index* best = nullptr;
+            size_t depth = 0;
+            for (const auto& index : c.indexes) {
+                size_t k = 0;
+                while (k < index.fields.size() && isEquality(query, index.fields[k])) k++;
+                if (k > depth) { best = &index; depth = k; }
+            }
+
+            fluxdb::Id after = idAfter(query);
+            if (!best) {
+                counters.full_scans++;
+                for (auto it = c.docs.upper_bound(after); it != c.docs.end(); ++it)
+                    if (!visit(it->first, it->second)) return;
+                return;
+            }
+            counters.index_scans++;
+
+            IndexKey prefix;
+            for (size_t k = 0; k < depth; k++) prefix.push_back(*query.at(best->fields[k]));
+
+            auto visitIds = [&](auto first, auto last) {
+                for (; first != last; ++first) {
+                    auto it = c.docs.find(*first);
+                    if (it != c.docs.end() && !visit(*first, it->second)) return;
+                }
+            };
+
+            if (depth == best->fields.size()) {
+                auto it = best->entries.find(prefix);
+                if (it != best->entries.end()) visitIds(it->second.upper_bound(after), it->second.end());
+                return;
+            }
+
+            // Leading fields only: several keys, merged back into id order
+            std::vector<fluxdb::Id> ids;
+            for (auto it = best->entries.lower_bound(prefix); it != best->entries.end() && samePrefix(it->first, prefix); ++it)
+                ids.insert(ids.end(), it->second.upper_bound(after), it->second.end());
+            std::sort(ids.begin(), ids.end());
+            visitIds(ids.begin(), ids.end());
+        }
+
+        // False if the index already exists
+        bool doCreateIndex(Session& s, const std::vector<std::string>& fields) {
+            Collection& c = collection(s.db);
+            std::unique_lock<std::shared_mutex> lk(c.lock);
+            for (const auto& index : c.indexes)
+                if (index.fields == fields) return false;
+
+            Index index;
+            index.fields = fields;
+            for (const auto& [id, doc] : c.docs) index.entries[indexKey(index, doc)].insert(id);
+            c.indexes.push_back(std::move(index));
+            return true;
+        }
+
+        bool doDropIndex(Session& s, const std::vector<std::string>& fields) {
+            Collection& c = collection(s.db);
+            std::unique_lock<std::shared_mutex> lk(c.lock);
+            auto it = std::find_if(c.indexes.begin(), c.indexes.end(), [&](const Index& index) { return index.fields == fields; });
+            if (it == c.indexes.end()) return false;
+            c.indexes.erase(it);
+            return true;
+        }
+
+        std::vector<std::vector<std::string>> doListIndexes(Session& s) {
+            Collection& c = collection(s.db);
+            std::shared_lock<std::shared_mutex> lk(c.lock);
+            std::vector<std::vector<std::string>> out;
+            for (const auto& index : c.indexes) out.push_back(index.fields);
+            return out;
+        }
+
+        // --- STORAGE (shared by both protocols) ---
+
+        fluxdb::Id doInsert(Session& s, fluxdb::Document doc) {
+            Collection& c = collection(s.db);
+            std::unique_lock<std::shared_mutex> lk(c.lock);
+            fluxdb::Id id = c.next_id++;
+            for (auto& index : c.indexes) index.entries[indexKey(index, doc)].insert(id);
+            c.docs.emplace(id, std::move(doc));
+            return id;
+        }
+
+        bool doUpdate(Session& s, fluxdb::Id id, const fluxdb::Document& patch) {
+            Collection& c = collection(s.db);
+            std::unique_lock<std::shared_mutex> lk(c.lock);
+            auto it = c.docs.find(id);
+            if (it == c.docs.end()) return false;
+
+            std::vector<IndexKey> before;
+            for (const auto& index : c.indexes) before.push_back(indexKey(index, it->second));
+            for (auto& [key, val] : patch) it->second[key] = val; // fields merge, like fluxd
+            for (size_t i = 0; i < c.indexes.size(); i++) {
+                Index& index = c.indexes[i];
+                IndexKey after = indexKey(index, it->second);
+                if (!KeyLess()(before[i], after) && !KeyLess()(after, before[i])) continue;
+                unindex(index, before[i], id);
+                index.entries[std::move(after)].insert(id);
+            }
+            return true;
+        }
+
+        bool doDelete(Session& s, fluxdb::Id id) {
+            Collection& c = collection(s.db);
+            std::unique_lock<std::shared_mutex> lk(c.lock);
+            auto it = c.docs.find(id);
+            if (it == c.docs.end()) return false;
+            for (auto& index : c.indexes) unindex(index, indexKey(index, it->second), id);
+            c.docs.erase(it);
+            return true;
+        }
+
+        // Calls emit(id, doc) for each match, in id order, under the read lock
+        template <typename Emit>
+        size_t doFind(Session& s, const fluxdb::Document& query, size_t skip, size_t limit, Emit emit) {
+            size_t count = 0, seen = 0;
+            Collection& c = collection(s.db);
+            std::shared_lock<std::shared_mutex> lk(c.lock);
+            candidates(c, query, [&](fluxdb::Id id, const fluxdb::Document& doc) {
+                if (count >= limit) return false;
+                if (!matches(id, doc, query)) return true;
+                if (seen++ < skip) return true;
+                emit(id, doc);
+                count++;
+                return true;
+            });
+            return count;
+        }
+
+        std::pair<size_t, double> doCount(Session& s, const fluxdb::Document& query, const std::string& sumField) {
+            size_t count = 0;
+            double sum = 0.0;
+            Collection& c = collection(s.db);
+            std::shared_lock<std::shared_mutex> lk(c.lock);
+            candidates(c, query, [&](fluxdb::Id id, const fluxdb::Document& doc) {
+                if (!matches(id, doc, query)) return true;
+                count++;
+                if (sumField.empty()) return true;
+                auto it = doc.find(sumField);
+                if (it != doc.end() && it->second->isNumber()) sum += it->second->getNumeric();
+                return true;
+            });
+            return { count, sum };
+        }
+
+        size_t doPublish(const std::string& channel, const std::string& message) {
+            std::vector<std::shared_ptr<Session>> receivers;
+            {
+                std::lock_guard<std::mutex> lk(channels_lock);
+                auto it = channels.find(channel);
+                if (it != channels.end()) receivers = it->second;
+            }
+
+            // Each subscriber gets the frame for the protocol it negotiated
+            std::string text, framed;
+            for (auto& r : receivers) {
+                if (r->binary) {
+                    if (framed.empty()) {
+                        fluxdb::wire::Writer w(framed);
+                        w.begin();
+                        w.status(fluxdb::wire::Status::Message);
+                        w.str(channel);
+                        w.str(message);
+                        w.end();
+                    }
+                    write(*r, framed);
+                } else {
+                    if (text.empty()) text = "MESSAGE " + channel + " " + message + "\n";
+                    write(*r, text);
+                }
+            }
+            return receivers.size();
+        }
+
+        void doSubscribe(const std::shared_ptr<Session>& s, const std::string& channel) {
+            std::lock_guard<std::mutex> lk(channels_lock);
+            channels[channel].push_back(s);
+        }
+
+        // --- TEXT COMMANDS ---
+
+        std::string cmdInsert(Session& s, const std::string& args) {
+            fluxdb::Document doc = fluxdb::QueryParser(args).parseJSON();
+            return "OK ID=" + std::to_string(doInsert(s, std::move(doc))) + "\n";
+        }
+
+        std::string cmdUpdate(Session& s, const std::string& args) {
+            size_t space = args.find(' ');
+            if (space == std::string::npos) return "ERR SYNTAX\n";
+            fluxdb::Id id = std::stoull(args.substr(0, space));
+            fluxdb::Document patch = fluxdb::QueryParser(args.substr(space + 1)).parseJSON();
+            return doUpdate(s, id, patch) ? "OK UPDATED\n" : "ERR NOT_FOUND\n";
+        }
+
+        std::string cmdDelete(Session& s, const std::string& args) {
+            return doDelete(s, std::stoull(args)) ? "OK DELETED\n" : "ERR NOT_FOUND\n";
+        }
+
+        // FIND <json> [SKIP n] [LIMIT n] -> OK COUNT=<rows>\nID <id> <json>\n...
+        std::string cmdFind(Session& s, const std::string& args) {
+            std::string json, tail;
+            if (!splitJson(args, json, tail)) return "ERR SYNTAX\n";
+            fluxdb::Document query = fluxdb::QueryParser(json).parseJSON();
+
+            size_t skip = 0, limit = SIZE_MAX;
+            std::stringstream opts(tail);
+            std::string word;
+            while (opts >> word) {
+                if (word == "SKIP") opts >> skip;
+                else if (word == "LIMIT") opts >> limit;
+            }
+
+            std::string rows;
+            size_t count = doFind(s, query, skip, limit, [&](fluxdb::Id id, const fluxdb::Document& doc) {
+                rows += "ID " + std::to_string(id) + " " + fluxdb::Value(doc).ToJson() + "\n";
+            });
+            return "OK COUNT=" + std::to_string(count) + "\n" + rows;
+        }
+
+        // COUNT <json> [SUM field] -> OK COUNT=<n> [SUM=<x>]
+        std::string cmdCount(Session& s, const std::string& args) {
+            std::string json, tail;
+            if (!splitJson(args, json, tail)) return "ERR SYNTAX\n";
+            fluxdb::Document query = fluxdb::QueryParser(json).parseJSON();
+
+            std::string sumField;
+            std::stringstream opts(tail);
+            std::string word;
+            while (opts >> word) {
+                if (word == "SUM") opts >> sumField;
+            }
+
+            auto [count, sum] = doCount(s, query, sumField);
+            std::string resp = "OK COUNT=" + std::to_string(count);
+            if (!sumField.empty()) resp += " SUM=" + fluxdb::Value(sum).ToJson();
+            return resp + "\n";
+        }
+
+        // INDEX CREATE|DROP <field>[,<field>...] | INDEX LIST
+        std::string cmdIndex(Session& s, const std::string& args) {
+            std::stringstream in(args);
+            std::string verb, spec;
+            in >> verb >> spec;
+            if (verb == "LIST") {
+                auto indexes = doListIndexes(s);
+                std::string resp = "OK COUNT=" + std::to_string(indexes.size()) + "\n";
+                for (const auto& fields : indexes) {
+                    resp += "INDEX ";
+                    for (size_t i = 0; i < fields.size(); i++) resp += (i ? "," : "") + fields[i];
+                    resp += "\n";
+                }
+                return resp;
+            }
+
+            std::vector<std::string> fields;
+            std::stringstream list(spec);
+            std::string field;
+            while (std::getline(list, field, ',')) {
+                if (field.empty()) return "ERR SYNTAX\n";
+                fields.push_back(field);
+            }
+            if (fields.empty()) return "ERR SYNTAX\n";
+
+            if (verb == "CREATE") return doCreateIndex(s, fields) ? "OK INDEX_CREATED\n" : "OK INDEX_EXISTS\n";
+            if (verb == "DROP") return doDropIndex(s, fields) ? "OK INDEX_DROPPED\n" : "ERR NOT_FOUND\n";
+            return "ERR SYNTAX\n";
+        }
+
+        std::string cmdPublish(const std::string& args) {
+            size_t space = args.find(' ');
+            if (space == std::string::npos) return "ERR SYNTAX\n";
+            size_t receivers = doPublish(args.substr(0, space), args.substr(space + 1));
+            return "OK RECEIVERS=" + std::to_string(receivers) + "\n";
+        }
+
+        std::string cmdSubscribe(const std::shared_ptr<Session>& s, const std::string& channel) {
+            doSubscribe(s, channel);
+            return "OK SUBSCRIBED " + channel + "\n";
+        }
+
+        std::string dispatch(const std::shared_ptr<Session>& s, const std::string& line) {
+            size_t space = line.find(' ');
+            std::string cmd = line.substr(0, space);
+            std::string args = (space == std::string::npos) ? "" : line.substr(space + 1);
+
+            if (cmd == "AUTH") {
+                s->authed = config.password.empty() || args == config.password;
+                return s->authed ? "OK AUTHENTICATED\n" : "ERR AUTH_FAILED\n";
+            }
+            if (line == fluxdb::wire::HELLO && config.binary) {
+                s->binary = true;
+                counters.binary_sessions++;
+                return std::string(fluxdb::wire::HELLO_OK) + "\n";
+            }
+            if (!s->authed && !config.password.empty()) return "ERR NOT_AUTHENTICATED\n";
+
+            try {
+                if (cmd == "USE")       { s->db = args; return "OK SWITCHED_TO " + args + "\n"; }
+                if (cmd == "INSERT")    return cmdInsert(*s, args);
+                if (cmd == "UPDATE")    return cmdUpdate(*s, args);
+                if (cmd == "DELETE")    return cmdDelete(*s, args);
+                if (cmd == "FIND")      return cmdFind(*s, args);
+                if (cmd == "COUNT")     return cmdCount(*s, args);
+                if (cmd == "INDEX")     return cmdIndex(*s, args);
+                if (cmd == "PUBLISH")   return cmdPublish(args);
+                if (cmd == "SUBSCRIBE") return cmdSubscribe(s, args);
+            } catch (const std::exception& e) {
+                return std::string("ERR ") + e.what() + "\n";
+            }
+            return "ERR UNKNOWN_COMMAND\n";
+        }
+
+        // --- BINARY COMMANDS ---
+
+        // Decodes one request frame and appends the reply frame to `out`.
+        // A frame that fails to decode throws: the field-name tables would be
+        // out of step, so the caller hangs up.
+        void dispatchBinary(const std::shared_ptr<Session>& s, const std::string& payload, std::string& out) {
+            using namespace fluxdb::wire;
+            Reader in(payload.data(), payload.size());
+            Writer w(out);
+            w.begin();
+            auto fail = [&](const std::string& reason) {
+                w.status(Status::Err);
+                w.str(reason);
+                w.end();
+            };
+
+            Op op = (Op)in.u8();
+            if (op == Op::Auth) {
+                s->authed = config.password.empty() || in.str() == config.password;
+                if (!s->authed) return fail("AUTH_FAILED");
+                w.status(Status::Ok);
+                w.end();
+                return;
+            }
+
+            // Decode fully before the auth check so the tables stay in step
+            fluxdb::Document doc;
+            fluxdb::Id id = 0;
+            std::string a, b;
+            uint64_t skip = 0, limit = 0;
+            switch (op) {
+                case Op::Use: case Op::Subscribe: case Op::Text: a = in.str(); break;
+                case Op::Insert: doc = in.doc(s->keys_in); break;
+                case Op::Update: id = in.varint(); doc = in.doc(s->keys_in); break;
+                case Op::Delete: id = in.varint(); break;
+                case Op::Find:   doc = in.doc(s->keys_in); skip = in.varint(); limit = in.varint(); break;
+                case Op::Count:  doc = in.doc(s->keys_in); a = in.str(); break;
+                case Op::Publish: a = in.str(); b = in.str(); break;
+                default: throw std::runtime_error("Unknown op");
+            }
+            if (!s->authed && !config.password.empty()) return fail("NOT_AUTHENTICATED");
+
+            switch (op) {
+                case Op::Use:
+                    s->db = a;
+                    w.status(Status::Ok);
+                    break;
+                case Op::Insert:
+                    w.status(Status::Ok);
+                    w.varint(doInsert(*s, std::move(doc)));
+                    break;
+                case Op::Update:
+                    if (!doUpdate(*s, id, doc)) return fail("NOT_FOUND");
+                    w.status(Status::Ok);
+                    break;
+                case Op::Delete:
+                    if (!doDelete(*s, id)) return fail("NOT_FOUND");
+                    w.status(Status::Ok);
+                    break;
+                case Op::Find: {
+                    w.status(Status::Ok);
+                    size_t count_at = out.size();
+                    out.append(5, '\0'); // row count, patched below as a padded varint
+                    size_t rows = doFind(*s, doc, (size_t)skip, limit ? (size_t)(limit - 1) : SIZE_MAX,
+                        [&](fluxdb::Id row_id, const fluxdb::Document& row) {
+                            w.varint(row_id);
+                            w.doc(row, s->keys_out);
+                        });
+                    for (int i = 0; i < 5; i++)
+                        out[count_at + i] = (char)(((rows >> (7 * i)) & 0x7f) | (i < 4 ? 0x80 : 0));
+                    break;
+                }
+                case Op::Count: {
+                    auto [count, sum] = doCount(*s, doc, a);
+                    w.status(Status::Ok);
+                    w.varint(count);
+                    w.f64(sum);
+                    break;
+                }
+                case Op::Publish:
+                    w.status(Status::Ok);
+                    w.varint(doPublish(a, b));
+                    break;
+                case Op::Subscribe:
+                    doSubscribe(s, a);
+                    w.status(Status::Ok);
+                    break;
+                case Op::Text: {
+                    std::string text = dispatch(s, a);
+                    if (!text.empty() && text.back() == '\n') text.pop_back();
+                    w.status(Status::Ok);
+                    w.str(text);
+                    break;
+                }
+                default:
+                    break;
+            }
+            w.end();
+        }
+
+        // --- I/O WITH FAULTS ---
+
+        bool write(Session& s, const std::string& data) {
+            std::lock_guard<std::mutex> lk(s.write_lock);
+            if (s.sock == INVALID_SOCKET) return false;
+            const FaultConfig& f = config.faults;
+            size_t chunk = f.split_bytes ? f.split_bytes : data.size();
+
+            for (size_t off = 0; off < data.size(); off += chunk) {
+                size_t len = std::min(chunk, data.size() - off);
+                size_t sent = 0;
+                while (sent < len) {
+                    int n = send(s.sock, data.data() + off + sent, (int)(len - sent), FLUX_SEND_FLAGS);
+                    if (n <= 0) return false;
+                    sent += n;
+                }
+                counters.bytes_out += len;
+
+                if (f.bandwidth_bps)
+                    std::this_thread::sleep_for(std::chrono::microseconds(len * 1000000 / f.bandwidth_bps));
+                if (f.split_delay_us && off + len < data.size())
+                    std::this_thread::sleep_for(std::chrono::microseconds(f.split_delay_us));
+            }
+            return true;
+        }
+
+        // latency_ms models the network: a reply is held until latency_ms after its
+        // command arrived, so pipelined commands overlap. Per-command latency models
+        // server work and is paid in full, one command after another.
+        void injectLatency(const std::string& cmd, std::chrono::steady_clock::time_point arrived) {
+            const FaultConfig& f = config.faults;
+            auto it = f.command_latency_ms.find(cmd);
+            if (it != f.command_latency_ms.end() && it->second > 0)
+                std::this_thread::sleep_for(std::chrono::milliseconds(it->second));
+            if (f.latency_ms > 0) std::this_thread::sleep_until(arrived + std::chrono::milliseconds(f.latency_ms));
+        }
+
+        void serve(std::shared_ptr<Session> s) {
+            std::string inbox;
+            char buffer[4096];
+            std::uniform_real_distribution<double> coin(0.0, 1.0);
+
+            while (running) {
+                int bytes = recv(s->sock, buffer, sizeof(buffer), 0);
+                if (bytes <= 0) break;
+                auto arrived = std::chrono::steady_clock::now();
+                inbox.append(buffer, bytes);
+                counters.bytes_in += bytes;
+
+                bool alive = true;
+                std::string line, reply;
+                while (alive && !s->binary) {
+                    size_t nl = inbox.find('\n');
+                    if (nl == std::string::npos) break;
+                    line = inbox.substr(0, nl);
+                    inbox.erase(0, nl + 1);
+                    if (!line.empty() && line.back() == '\r') line.pop_back();
+                    if (line.empty()) continue;
+
+                    counters.commands++;
+                    if (config.verbose) std::cout << "[mock] " << line.substr(0, 120) << "\n";
+
+                    if (config.faults.drop_rate > 0 && coin(s->rng) < config.faults.drop_rate) {
+                        counters.dropped++;
+                        alive = false;
+                        break;
+                    }
+
+                    injectLatency(line.substr(0, line.find(' ')), arrived);
+                    alive = write(*s, dispatch(s, line));
+                }
+
+                // After HELLO the rest of the stream is frames
+                while (alive && s->binary) {
+                    try {
+                        if (!fluxdb::wire::takeFrame(inbox, line)) break;
+                    } catch (...) { alive = false; break; }
+                    if (line.empty()) { alive = false; break; }
+
+                    const char* name = fluxdb::wire::opName((fluxdb::wire::Op)line[0]);
+                    counters.commands++;
+                    if (config.verbose) std::cout << "[mock] <" << name << " frame, " << line.size() << " bytes>\n";
+
+                    if (config.faults.drop_rate > 0 && coin(s->rng) < config.faults.drop_rate) {
+                        counters.dropped++;
+                        alive = false;
+                        break;
+                    }
+
+                    injectLatency(name, arrived);
+                    reply.clear();
+                    try {
+                        dispatchBinary(s, line, reply);
+                    } catch (const std::exception& e) {
+                        if (config.verbose) std::cout << "[mock] bad frame: " << e.what() << "\n";
+                        alive = false;
+                        break;
+                    }
+                    alive = write(*s, reply);
+                }
+                if (!alive) break;
+            }
+
+            {
+                std::lock_guard<std::mutex> lk(channels_lock);
+                for (auto& [name, subs] : channels)
+                    subs.erase(std::remove(subs.begin(), subs.end(), s), subs.end());
+            }
+
+            std::lock_guard<std::mutex> lk(sessions_lock);
+            {
+                std::lock_guard<std::mutex> wl(s->write_lock);
+                closesocket(s->sock);
+                s->sock = INVALID_SOCKET;
+            }
+            sessions.erase(std::remove(sessions.begin(), sessions.end(), s), sessions.end());
+            sessions_done.notify_all();
+        }
+
+        void acceptLoop() {
+            while (running) {
+                fd_set readable;
+                FD_ZERO(&readable);
+                FD_SET(listener, &readable);
+                timeval tv{0, 100000}; // poll running every 100ms
+                if (select((int)listener + 1, &readable, nullptr, nullptr, &tv) <= 0) continue;
+
+                SOCKET client = accept(listener, nullptr, nullptr);
+                if (client == INVALID_SOCKET) continue;
+
+                int one = 1;
+                setsockopt(client, IPPROTO_TCP, TCP_NODELAY, (const char*)&one, sizeof(one));
+
+                auto s = std::make_shared<Session>();
+                s->sock = client;
+                counters.connections++;
+
+                std::lock_guard<std::mutex> lk(sessions_lock);
+                s->rng.seed(config.faults.seed + session_seq++);
+                sessions.push_back(s);
+                std::thread(&MockServer::serve, this, s).detach();
+            }
+        }
+
+    public:
+        explicit MockServer(ServerConfig cfg) : config(std::move(cfg)) {}
+
+        MockServer(const MockServer&) = delete;
+        MockServer& operator=(const MockServer&) = delete;
+
+        ~MockServer() { stop(); }
+
+        bool start() {
+            WSADATA wsaData;
+            WSAStartup(MAKEWORD(2, 2), &wsaData);
+
+            listener = socket(AF_INET, SOCK_STREAM, 0);
+            if (listener == INVALID_SOCKET) return false;
+
+            int one = 1;
+            setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, (const char*)&one, sizeof(one));
+
+            sockaddr_in addr{};
+            addr.sin_family = AF_INET;
+            addr.sin_port = htons((unsigned short)config.port);
+            addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+            if (bind(listener, (sockaddr*)&addr, sizeof(addr)) == SOCKET_ERROR || listen(listener, 64) == SOCKET_ERROR) {
+                closesocket(listener);
+                listener = INVALID_SOCKET;
+                return false;
+            }
+
+            socklen_t len = sizeof(addr);
+            getsockname(listener, (sockaddr*)&addr, &len);
+            bound_port = ntohs(addr.sin_port);
+
+            running = true;
+            acceptor = std::thread(&MockServer::acceptLoop, this);
+            return true;
+        }
+
+        void stop() {
+            if (!running.exchange(false)) return;
+            if (acceptor.joinable()) acceptor.join();
+            closesocket(listener);
+            listener = INVALID_SOCKET;
+
+            std::unique_lock<std::mutex> lk(sessions_lock);
+            for (auto& s : sessions) {
+                std::lock_guard<std::mutex> wl(s->write_lock);
+                if (s->sock != INVALID_SOCKET) shutdown(s->sock, FLUX_SHUT_RDWR); // unblocks recv()
+            }
+            sessions_done.wait(lk, [this]() { return sessions.empty(); });
+            lk.unlock();
+            WSACleanup();
+        }
+
+        int port() const { return bound_port; }
+        const ServerStats& stats() const { return counters; }
+    };
+}